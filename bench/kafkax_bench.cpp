@@ -0,0 +1,458 @@
+// kafkax_bench: hot-path microbenchmarks, no broker needed.
+//
+//   ring    detail::SPSCRing push/pop between two pinned threads (throughput
+//           with loaded handoff latency, and unloaded ping-pong)
+//   decode  Core::decode_raws itself on source messages: routing, pooled
+//           Events, decoder_stats, the flight recorder, zero-copy and the
+//           event-ring push, with the built-in decoders bound
+//   drain   Core::drainTo + recycle over pre-filled event rings, for several
+//           limits and lane counts
+//
+// One JSON object per line on stdout:
+//   {"bench":..., <params>, "msgs":N, "ns_per_msg":x, "allocs_per_msg":y,
+//    "p50_ns":..,"p90_ns":..,"p99_ns":..,"p999_ns":..,"max_ns":..}
+// Percentiles are per message (ring) or per call / batch size (decode, drain).
+// allocs_per_msg counts operator new in this process (not librdkafka's malloc).
+//
+// Needs KAFKAX_BENCH_ACCESS (set by bench/CMakeLists.txt) for Core's friend CoreBench.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kafkax/core.hpp"
+#include "kafkax/decoder.h"
+#include "kafkax/latency.hpp"
+#include "kafkax/message_source.hpp"
+#include "kafkax/placement.hpp"
+
+namespace {
+    std::atomic<std::uint64_t> g_allocs{0};
+}
+
+// counting replacements for the global allocator; GCC flags malloc/free inside them
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return ::operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace kafkax {
+
+    /* Bench-only access to Core (friend of Core): lets drainTo run against
+     * known contents, and decode_raws run on the bench thread, while the
+     * consumer/decode threads sit idle on a subscription that never gets data. */
+    struct CoreBench {
+        using Scratch = Core::DecodeScratch;
+        static constexpr std::size_t kDecodeBatch = Core::kDecodeBatch;
+
+        static void init_scratch(Scratch& scratch) { Core::init_scratch(scratch); }
+
+        /* bench thread stands in for lane 0's decode worker: the real one never
+         * gets a raw message, so the rings keep one producer and one consumer */
+        static void decode(Core& c, Scratch& scratch, std::span<rd_kafka_message_t* const> msgs) {
+            for (std::size_t i = 0; i < msgs.size(); ++i)
+                scratch.raws[i] = Core::RawMsg(msgs[i]);
+            c.decode_raws(0, 0, scratch, msgs.size());
+        }
+
+        static int bind_builtin(Core& c, const std::string& topic, const char* symbol,
+                                kafkax_decode_fn fn, std::string& err) {
+            return c.registry_.bind_builtin(topic, symbol, fn, err);
+        }
+
+        /* bench thread stands in for lane's decode worker (the rings' only producer) */
+        static std::size_t publish(Core& c, std::size_t lane, std::span<std::unique_ptr<Event>> evs) {
+            const auto n = c.evt_qs_[lane]->try_push_n(evs);
+            c.total_evt_.fetch_add(n, std::memory_order_relaxed);
+            return n;
+        }
+
+        static bool reuse(Core& c, std::size_t lane, std::unique_ptr<Event>& ev) {
+            return c.free_qs_[lane]->try_pop(ev);
+        }
+    };
+
+} // namespace kafkax
+
+namespace {
+
+    using kafkax::Event;
+    using kafkax::LatencyHistogram;
+
+    inline std::int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /* Spin, then yield: keeps the numbers honest on dedicated cores and still
+     * finishes when both threads share one. */
+    template <class F>
+    void spin_until(F&& done) {
+        for (unsigned i = 0; !done(); ++i)
+            if (i >= 1024) std::this_thread::yield();
+    }
+
+    struct Options {
+        std::string filter;                 // run benches whose name starts with this
+        std::uint64_t msgs = 2'000'000;
+        std::vector<int> cpus{0, 1};        // producer, consumer
+    };
+
+    struct Result {
+        std::string bench;
+        std::string params;                 // preformatted ,"k":v pairs
+        std::uint64_t msgs = 0;
+        std::int64_t elapsed_ns = 0;
+        std::uint64_t allocs = 0;
+        const LatencyHistogram* hist = nullptr;
+    };
+
+    void print(const Result& r) {
+        std::int64_t q[5] = {0, 0, 0, 0, 0};   // p50 p90 p99 p999 max
+        if (r.hist) {
+            std::vector<std::uint64_t> acc(LatencyHistogram::kBuckets, 0);
+            r.hist->add_to(acc.data());
+            kafkax::percentiles(acc.data(), q);
+        }
+
+        const double n = r.msgs ? (double)r.msgs : 1.0;
+        std::printf("{\"bench\":\"%s\"%s,\"msgs\":%llu,\"ns_per_msg\":%.2f,\"allocs_per_msg\":%.4f,"
+                    "\"p50_ns\":%lld,\"p90_ns\":%lld,\"p99_ns\":%lld,\"p999_ns\":%lld,\"max_ns\":%lld}\n",
+                    r.bench.c_str(), r.params.c_str(), (unsigned long long)r.msgs,
+                    (double)r.elapsed_ns / n, (double)r.allocs / n,
+                    (long long)q[0], (long long)q[1], (long long)q[2], (long long)q[3], (long long)q[4]);
+        std::fflush(stdout);
+    }
+
+    void pin(const Options& opt, std::size_t which) {
+        if (opt.cpus.empty()) return;
+        (void)kafkax::placement::pin_current_thread({opt.cpus[which % opt.cpus.size()]});
+    }
+
+    /* ---------------- ring ---------------- */
+
+    using EventRing = kafkax::detail::SPSCRing<std::unique_ptr<Event>>;
+
+    /* Producer stamps each Event and pushes in batches of `batch`; the consumer
+     * records pop time - stamp and hands the shell back on a second ring, the
+     * same evt/free pairing Core uses. */
+    void bench_ring_throughput(const Options& opt, std::size_t cap, std::size_t batch) {
+        EventRing fwd(cap), back(cap);
+        for (std::size_t i = 0; i < cap; ++i) {
+            auto ev = std::make_unique<Event>();
+            (void)back.try_push(std::move(ev));
+        }
+
+        auto hist = std::make_unique<LatencyHistogram>();
+        const auto total = opt.msgs;
+        std::atomic<bool> go{false};
+
+        std::thread consumer([&] {
+            pin(opt, 1);
+            std::vector<std::unique_ptr<Event>> buf(batch);
+            spin_until([&] { return go.load(std::memory_order_acquire); });
+
+            std::uint64_t got = 0;
+            while (got < total) {
+                std::size_t n = 0;
+                spin_until([&] { return (n = fwd.try_pop_n(std::span<std::unique_ptr<Event>>(buf.data(), batch))) > 0; });
+                const auto t = now_ns();
+                for (std::size_t i = 0; i < n; ++i) hist->record(t - buf[i]->poll_ns);
+                std::size_t done = 0;
+                spin_until([&] { return (done += back.try_push_n(std::span<std::unique_ptr<Event>>(buf.data() + done, n - done))) == n; });
+                got += n;
+            }
+        });
+
+        pin(opt, 0);
+        std::vector<std::unique_ptr<Event>> buf(batch);
+        const auto a0 = g_allocs.load();
+        go.store(true, std::memory_order_release);
+        const auto t0 = now_ns();
+
+        std::uint64_t sent = 0;
+        while (sent < total) {
+            const auto want = (std::size_t)std::min<std::uint64_t>(batch, total - sent);
+            std::size_t have = 0;
+            spin_until([&] { return (have += back.try_pop_n(std::span<std::unique_ptr<Event>>(buf.data() + have, want - have))) == want; });
+
+            const auto t = now_ns();
+            for (std::size_t i = 0; i < want; ++i) buf[i]->poll_ns = t;
+
+            std::size_t done = 0;
+            spin_until([&] { return (done += fwd.try_push_n(std::span<std::unique_ptr<Event>>(buf.data() + done, want - done))) == want; });
+            sent += want;
+        }
+        consumer.join();
+        const auto t1 = now_ns();
+
+        char params[96];
+        std::snprintf(params, sizeof(params), ",\"capacity\":%zu,\"batch\":%zu", cap, batch);
+        print(Result{"ring.throughput", params, total, t1 - t0, g_allocs.load() - a0, hist.get()});
+    }
+
+    /* One Event bounces between two threads; half the round trip is the handoff. */
+    void bench_ring_pingpong(const Options& opt) {
+        EventRing ping(64), pong(64);
+        const auto rounds = std::max<std::uint64_t>(opt.msgs / 20, 1000);
+
+        std::thread echo([&] {
+            pin(opt, 1);
+            std::unique_ptr<Event> ev;
+            for (std::uint64_t i = 0; i < rounds; ++i) {
+                spin_until([&] { return ping.try_pop(ev); });
+                spin_until([&] { return pong.try_push(std::move(ev)); });
+            }
+        });
+
+        pin(opt, 0);
+        auto hist = std::make_unique<LatencyHistogram>();
+        auto ev = std::make_unique<Event>();
+        const auto a0 = g_allocs.load();
+        const auto t0 = now_ns();
+        for (std::uint64_t i = 0; i < rounds; ++i) {
+            const auto s = now_ns();
+            spin_until([&] { return ping.try_push(std::move(ev)); });
+            spin_until([&] { return pong.try_pop(ev); });
+            hist->record((now_ns() - s) / 2);
+        }
+        const auto t1 = now_ns();
+        echo.join();
+
+        print(Result{"ring.pingpong", "", rounds, (t1 - t0) / 2, g_allocs.load() - a0, hist.get()});
+    }
+
+    /* ---------------- decode ---------------- */
+
+    /* Never delivers: Core's consumer thread idles while the bench decodes. */
+    class IdleSource final : public kafkax::MessageSource {
+    public:
+        int subscribe(const std::vector<std::string>&, std::string&) override { return 0; }
+
+        std::size_t poll(std::span<rd_kafka_message_t*>, int timeout_ms) override {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+            return 0;
+        }
+    };
+
+    /* One Core::decode_raws call per batch of kDecodeBatch messages, timed
+     * from the raw messages to the events on the ring; building the messages
+     * and draining the events are not. */
+    void bench_decode(const Options& opt, const char* name, kafkax_decode_fn fn,
+                      std::size_t payload_size, std::size_t key_size, bool zero_copy) {
+        constexpr std::size_t kBatch = kafkax::CoreBench::kDecodeBatch;
+        static const std::string topic = "kafkax.bench";
+
+        std::vector<std::uint8_t> payload(payload_size), key(key_size);
+        for (std::size_t i = 0; i < payload.size(); ++i) payload[i] = (std::uint8_t)i;
+        for (std::size_t i = 0; i < key.size(); ++i) key[i] = (std::uint8_t)('a' + i % 26);
+
+        // outlives core: events still on its rings release their messages into it
+        kafkax::SourceMessagePool shells;
+
+        kafkax::Core::DecodeConfig dcfg{};
+        dcfg.decode_threads = 1;
+        dcfg.zero_copy = zero_copy;
+
+        kafkax::Core core(dcfg);
+        std::string err;
+        if (core.set_source(std::make_unique<IdleSource>(), err) != 0 ||
+            core.subscribe({topic}, err) != 0 ||
+            kafkax::CoreBench::bind_builtin(core, topic, name, fn, err) != 0) {
+            std::fprintf(stderr, "decode: setup failed: %s\n", err.c_str());
+            return;
+        }
+
+        kafkax::CoreBench::Scratch scratch;
+        kafkax::CoreBench::init_scratch(scratch);
+
+        std::vector<rd_kafka_message_t*> msgs(kBatch);
+        std::vector<Event> out;
+        out.reserve(kBatch);
+
+        auto hist = std::make_unique<LatencyHistogram>();
+        const auto batches = std::max<std::uint64_t>(opt.msgs / kBatch, 1);
+        std::uint64_t errors = 0;
+        std::int64_t elapsed = 0;
+        std::uint64_t allocs = 0;
+        std::int64_t offset = 0;
+
+        // batch 0 warms the shell pool, the Event pool and the worker's scratch
+        for (std::uint64_t b = 0; b <= batches; ++b) {
+            for (std::size_t i = 0; i < kBatch; ++i, ++offset)
+                msgs[i] = shells.make(&topic, (std::int32_t)(i % 8), offset, -1,
+                                      key_size ? key.data() : nullptr, key.size(),
+                                      payload.data(), payload.size());
+
+            const auto a0 = g_allocs.load();
+            const auto s = now_ns();
+            kafkax::CoreBench::decode(core, scratch, msgs);
+            const auto d = now_ns() - s;
+            if (b > 0) {
+                allocs += g_allocs.load() - a0;
+                hist->record(d / (std::int64_t)kBatch, kBatch);
+                elapsed += d;
+            }
+
+            for (std::size_t got = 0; got < kBatch;) {
+                core.drainTo(out, kBatch - got);
+                got += out.size();
+                for (const auto& ev : out) errors += ev.kind != Event::Kind::Data;
+                core.recycle(out);
+            }
+        }
+
+        if (errors) std::fprintf(stderr, "decode.%s: %llu errors\n", name, (unsigned long long)errors);
+
+        char params[160];
+        std::snprintf(params, sizeof(params), ",\"decoder\":\"%s\",\"payload\":%zu,\"key\":%zu,\"zero_copy\":%d",
+                      name, payload_size, key_size, zero_copy ? 1 : 0);
+        print(Result{"decode", params, batches * kBatch, elapsed, allocs, hist.get()});
+    }
+
+    /* ---------------- drain ---------------- */
+
+    void bench_drain(const Options& opt, std::size_t lanes, std::size_t limit) {
+        kafkax::Core::DecodeConfig dcfg{};
+        dcfg.decode_threads = lanes;
+        dcfg.raw_queue_size = 1024;
+        dcfg.evt_queue_size = 8192;
+        dcfg.flight_recorder = 0;
+
+        kafkax::Core::KafkaConfig kcfg{};
+        kcfg.bootstrap_servers = "127.0.0.1:9";   // never answers; no data is fetched
+        kcfg.group_id = "kafkax_bench";
+        kcfg.extra["log_level"] = "0";
+
+        kafkax::Core core(dcfg, kcfg);
+        std::string err;
+        if (core.subscribe({"kafkax.bench"}, err) != 0) {
+            std::fprintf(stderr, "drain: subscribe failed: %s\n", err.c_str());
+            return;
+        }
+        const auto topic_id = core.topic_id("kafkax.bench");
+
+        std::vector<std::unique_ptr<Event>> stage(dcfg.evt_queue_size);
+        std::vector<Event> out;
+        out.reserve(limit);
+
+        auto hist = std::make_unique<LatencyHistogram>();
+        const auto total = std::max<std::uint64_t>(opt.msgs, lanes * dcfg.evt_queue_size);
+        std::uint64_t drained = 0;
+        std::int64_t elapsed = 0;
+        std::uint64_t allocs = 0;
+        std::int64_t offset = 0;
+
+        while (drained < total) {
+            // refill every lane (untimed), reusing recycled events like a decode worker
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                for (auto& ev : stage) {
+                    if (!kafkax::CoreBench::reuse(core, lane, ev)) ev = std::make_unique<Event>();
+                    ev->kind = Event::Kind::Data;
+                    ev->worker = (std::uint32_t)lane;
+                    ev->topic_id = topic_id;
+                    ev->partition = (std::int32_t)lane;
+                    ev->offset = offset++;
+                    ev->bytes.resize(64);
+                }
+                std::size_t done = 0;
+                while (done < stage.size())
+                    done += kafkax::CoreBench::publish(core, lane, std::span<std::unique_ptr<Event>>(stage).subspan(done));
+            }
+
+            const auto a0 = g_allocs.load();
+            const auto round = (std::uint64_t)lanes * dcfg.evt_queue_size;
+            std::uint64_t got = 0;
+            while (got < round) {
+                const auto s = now_ns();
+                core.drainTo(out, limit);
+                const auto n = out.size();
+                core.recycle(out);
+                const auto d = now_ns() - s;
+                if (n == 0) break;
+                hist->record(d / (std::int64_t)n, n);
+                elapsed += d;
+                got += n;
+            }
+            allocs += g_allocs.load() - a0;
+            drained += got;
+            if (got < round) break;
+        }
+
+        char params[96];
+        std::snprintf(params, sizeof(params), ",\"lanes\":%zu,\"limit\":%zu", lanes, limit);
+        print(Result{"drain", params, drained, elapsed, allocs, hist.get()});
+    }
+
+    bool selected(const Options& opt, const char* bench) {
+        return opt.filter.empty() || std::strncmp(bench, opt.filter.c_str(), opt.filter.size()) == 0;
+    }
+
+    void print_usage(const char* prog) {
+        std::fprintf(stderr,
+            "Usage: %s [--filter ring|decode|drain] [--msgs N] [--cpus LIST]\n"
+            "  --cpus  taskset-style list; the first two CPUs host the ring producer/consumer\n"
+            "          (default 0,1; empty string = unpinned)\n", prog);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        if ((a == "--filter" || a == "--msgs" || a == "--cpus") && i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (a == "--filter") opt.filter = argv[++i];
+        else if (a == "--msgs") opt.msgs = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--cpus") {
+            opt.cpus.clear();
+            if (!kafkax::placement::parse_cpu_list(argv[++i], opt.cpus)) {
+                std::fprintf(stderr, "bad --cpus list\n");
+                return 1;
+            }
+        } else {
+            print_usage(argv[0]);
+            return a == "-h" || a == "--help" ? 0 : 1;
+        }
+    }
+
+    if (selected(opt, "ring")) {
+        for (std::size_t batch : {1, 16, 64, 256})
+            bench_ring_throughput(opt, 8192, batch);
+        bench_ring_pingpong(opt);
+    }
+
+    if (selected(opt, "decode")) {
+        for (std::size_t size : {64, 512, 4096, 65536}) {
+            bench_decode(opt, "default", kafkax_default_decoder, size, 16, false);
+            bench_decode(opt, "passthrough", kafkax_passthrough_decoder, size, 0, false);
+            bench_decode(opt, "passthrough", kafkax_passthrough_decoder, size, 0, true);
+        }
+    }
+
+    if (selected(opt, "drain")) {
+        for (std::size_t lanes : {1, 2, 4, 8})
+            for (std::size_t limit : {64, 256, 1024, 4096})
+                bench_drain(opt, lanes, limit);
+    }
+
+    return 0;
+}
@@ -0,0 +1,467 @@
+// kafkax_bench_decoder: measure a decoder plugin before binding it.
+//
+// The plugin is loaded through DecoderRegistry::bind, so it passes the same
+// ABI version check and symbol lookup (<symbol>, <symbol>_batch) as in
+// production. Envelopes come from a capture file (include/kafkax/capture.hpp)
+// or a generator, and are decoded the way Core does it:
+//   single  <symbol> per message into a recycled buffer (>= 4096 bytes),
+//           re-called once on NEED_MORE with the requested size
+//   batch   <symbol>_batch over runs of 64 into a shared arena (64KB, grown
+//           on NEED_MORE), outputs copied out per message (ABI v3 plugins)
+// Each mode runs at every --threads count; all threads decode the full set.
+//
+// One JSON object per line on stdout:
+//   {"mode":"single","threads":N,"msgs":..,"ns_per_msg":..,"msg_per_s":..,
+//    "in_bytes_per_msg":..,"out_bytes_per_msg":..,"need_more_rate":..,"errors":..,
+//    "plugin_allocs_per_msg":..,"plugin_alloc_bytes_per_msg":..,"p50_ns":..,...}
+// plugin_allocs counts malloc/calloc/realloc, the aligned variants
+// (posix_memalign, aligned_alloc, memalign, valloc, pvalloc) and so operator
+// new, made on a decoding thread while it is inside the plugin (glibc only).
+#include <errno.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kafkax/capture.hpp"
+#include "kafkax/decoder.h"
+#include "kafkax/decoder_registry.hpp"
+#include "kafkax/latency.hpp"
+#include "kafkax/placement.hpp"
+
+/* ---------------- allocations inside the plugin ---------------- */
+
+extern "C" {
+    void* __libc_malloc(std::size_t);
+    void* __libc_calloc(std::size_t, std::size_t);
+    void* __libc_realloc(void*, std::size_t);
+    void* __libc_memalign(std::size_t, std::size_t);
+    void* __libc_valloc(std::size_t);
+    void* __libc_pvalloc(std::size_t);
+}
+
+namespace {
+    thread_local bool t_in_plugin = false;
+    std::atomic<std::uint64_t> g_plugin_allocs{0};
+    std::atomic<std::uint64_t> g_plugin_alloc_bytes{0};
+
+    inline void note_alloc(std::size_t n) noexcept {
+        if (!t_in_plugin) return;
+        g_plugin_allocs.fetch_add(1, std::memory_order_relaxed);
+        g_plugin_alloc_bytes.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /* marks the calling thread as inside the plugin for its lifetime */
+    struct InPlugin {
+        InPlugin() noexcept { t_in_plugin = true; }
+        ~InPlugin() { t_in_plugin = false; }
+    };
+}
+
+extern "C" {
+    void* malloc(std::size_t n) {
+        note_alloc(n);
+        return __libc_malloc(n);
+    }
+    void* calloc(std::size_t n, std::size_t size) {
+        note_alloc(n * size);
+        return __libc_calloc(n, size);
+    }
+    void* realloc(void* p, std::size_t n) {
+        note_alloc(n);
+        return __libc_realloc(p, n);
+    }
+
+    /* aligned: SIMD decoders tend to use these rather than malloc */
+    int posix_memalign(void** out, std::size_t align, std::size_t n) {
+        if (align < sizeof(void*) || (align & (align - 1)) != 0) return EINVAL;
+        note_alloc(n);
+        void* p = __libc_memalign(align, n);
+        if (!p && n != 0) return ENOMEM;
+        *out = p;
+        return 0;
+    }
+    void* aligned_alloc(std::size_t align, std::size_t n) {
+        note_alloc(n);
+        return __libc_memalign(align, n);
+    }
+    void* memalign(std::size_t align, std::size_t n) {
+        note_alloc(n);
+        return __libc_memalign(align, n);
+    }
+    void* valloc(std::size_t n) {
+        note_alloc(n);
+        return __libc_valloc(n);
+    }
+    void* pvalloc(std::size_t n) {
+        note_alloc(n);
+        return __libc_pvalloc(n);
+    }
+}
+
+namespace {
+
+    using kafkax::LatencyHistogram;
+
+    constexpr std::size_t kBatch = 64;                 // Core::kDecodeBatch
+    constexpr std::size_t kMinBuf = 4096;              // decode_message's floor
+    constexpr std::size_t kArena = 64 * 1024;          // Core::kDecodeArena
+
+    inline std::int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    struct Options {
+        std::string so_path;
+        std::string symbol;
+        std::string topic = "kafkax.bench";   // envelope topic (generator) / filter (capture)
+
+        std::string capture;                  // read envelopes from here
+        std::string write_capture;            // save generated envelopes here
+
+        /* generator */
+        std::uint64_t msgs = 100'000;
+        std::size_t size = 256;
+        std::size_t key_size = 0;
+        std::uint64_t seed = 1;
+
+        std::vector<int> threads{1};
+        std::uint64_t repeat = 10;
+        std::string mode = "both";            // single | batch | both
+    };
+
+    struct Input {
+        std::vector<std::uint8_t> storage;    // generator bytes
+        kafkax::CaptureReader capture;        // or a mapped capture
+        std::vector<std::string> topics;      // capture topics, stable for envelope views
+        std::vector<kafkax_envelope_t> envs;
+        std::uint64_t in_bytes = 0;
+    };
+
+    bool load_capture(const Options& opt, Input& in, std::string& err) {
+        if (!in.capture.open(opt.capture, err)) return false;
+
+        kafkax::CaptureRecord rec;
+        std::size_t n = 0;
+        while (in.capture.next(rec))
+            if (opt.topic.empty() || rec.topic == opt.topic) ++n;
+
+        in.envs.reserve(n);
+        in.capture.rewind();
+        while (in.capture.next(rec)) {
+            if (!opt.topic.empty() && rec.topic != opt.topic) continue;
+
+            kafkax_envelope_t env{};
+            env.topic = kafkax_str_view_t{rec.topic.data(), rec.topic.size()};
+            env.partition = rec.partition;
+            env.offset = rec.offset;
+            env.timestamp_ms = rec.timestamp_ms;
+            env.key = kafkax_bytes_view_t{rec.key.data(), rec.key.size()};
+            env.payload = kafkax_bytes_view_t{rec.payload.data(), rec.payload.size()};
+            in.envs.push_back(env);
+            in.in_bytes += rec.payload.size();
+        }
+        if (in.envs.empty()) {
+            err = opt.capture + ": no messages" + (opt.topic.empty() ? "" : " for topic " + opt.topic);
+            return false;
+        }
+        return true;
+    }
+
+    bool generate(const Options& opt, Input& in, std::string& err) {
+        std::mt19937_64 rng(opt.seed);
+        const std::size_t per = opt.size + opt.key_size;
+        in.storage.resize(per * opt.msgs);
+        for (auto& b : in.storage) b = static_cast<std::uint8_t>(rng());
+
+        in.topics.push_back(opt.topic);
+        const auto& topic = in.topics.back();
+
+        in.envs.resize(opt.msgs);
+        for (std::uint64_t i = 0; i < opt.msgs; ++i) {
+            const auto* p = in.storage.data() + i * per;
+            auto& env = in.envs[i];
+            env = kafkax_envelope_t{};
+            env.topic = kafkax_str_view_t{topic.data(), topic.size()};
+            env.partition = static_cast<std::int32_t>(i % 8);
+            env.offset = static_cast<std::int64_t>(i);
+            env.timestamp_ms = -1;
+            env.key = kafkax_bytes_view_t{opt.key_size ? p : nullptr, opt.key_size};
+            env.payload = kafkax_bytes_view_t{p + opt.key_size, opt.size};
+            in.in_bytes += opt.size;
+        }
+
+        if (opt.write_capture.empty()) return true;
+
+        kafkax::CaptureWriter w;
+        if (!w.open(opt.write_capture, err)) return false;
+        for (const auto& env : in.envs) {
+            kafkax::CaptureRecord rec;
+            rec.topic = std::string_view(env.topic.data, env.topic.len);
+            rec.partition = env.partition;
+            rec.offset = env.offset;
+            rec.timestamp_ms = env.timestamp_ms;
+            rec.key = std::span<const std::uint8_t>(env.key.data, env.key.len);
+            rec.payload = std::span<const std::uint8_t>(env.payload.data, env.payload.len);
+            if (!w.append(rec)) break;
+        }
+        return w.close(err);
+    }
+
+    struct ThreadStats {
+        std::uint64_t msgs = 0;
+        std::uint64_t out_bytes = 0;
+        std::uint64_t retries = 0;
+        std::uint64_t errors = 0;
+        std::int64_t elapsed_ns = 0;
+        std::unique_ptr<LatencyHistogram> hist = std::make_unique<LatencyHistogram>();
+    };
+
+    void run_single(const Options& opt, const Input& in, kafkax_decode_fn fn, ThreadStats& st) {
+        std::vector<std::vector<std::uint8_t>> pool(kBatch);   // recycled event buffers
+        kafkax_decode_out_t out;
+
+        const auto t0 = now_ns();
+        for (std::uint64_t r = 0; r < opt.repeat; ++r) {
+            for (std::size_t i = 0; i < in.envs.size(); ++i) {
+                auto& buf = pool[i % kBatch];
+                buf.resize(std::max(kMinBuf, buf.capacity()));
+
+                out.kind = KAFKAX_DECODE_ERR;
+                out.len = 0;
+                out.need = 0;
+                out.err_msg[0] = '\0';
+                out.buf = buf.data();
+                out.cap = buf.size();
+
+                const auto s = now_ns();
+                int rc;
+                {
+                    InPlugin guard;
+                    rc = fn(&in.envs[i], &out);
+                }
+                if (rc == 0 && out.kind == KAFKAX_DECODE_NEED_MORE && out.need > out.cap) {
+                    ++st.retries;
+                    buf.resize(out.need);
+                    out.buf = buf.data();
+                    out.cap = buf.size();
+                    InPlugin guard;
+                    rc = fn(&in.envs[i], &out);
+                }
+                st.hist->record(now_ns() - s);
+
+                if (rc != 0 || out.kind != KAFKAX_DECODE_OK) ++st.errors;
+                else st.out_bytes += out.len;
+            }
+        }
+        st.elapsed_ns = now_ns() - t0;
+        st.msgs = opt.repeat * in.envs.size();
+    }
+
+    void run_batch(const Options& opt, const Input& in, kafkax_decode_batch_fn batch_fn, ThreadStats& st) {
+        std::vector<std::uint8_t> arena(kArena);
+        std::vector<kafkax_decode_result_t> results(kBatch);
+        std::vector<std::vector<std::uint8_t>> outs(kBatch);   // per-event copies, as decode_run does
+
+        const auto t0 = now_ns();
+        for (std::uint64_t r = 0; r < opt.repeat; ++r) {
+            for (std::size_t base = 0; base < in.envs.size(); base += kBatch) {
+                const auto n = std::min(kBatch, in.envs.size() - base);
+                const auto* envs = in.envs.data() + base;
+                const auto s = now_ns();
+
+                std::size_t k = 0;
+                while (k < n) {
+                    kafkax_decode_batch_out_t out;
+                    out.arena = arena.data();
+                    out.cap = arena.size();
+                    out.used = 0;
+                    out.results = results.data() + k;
+                    out.count = 0;
+                    out.err_msg[0] = '\0';
+
+                    int rc;
+                    {
+                        InPlugin guard;
+                        rc = batch_fn(envs + k, n - k, &out);
+                    }
+                    if (rc != 0 || out.count == 0 || out.count > n - k) {
+                        st.errors += n - k;
+                        break;
+                    }
+
+                    std::size_t done = 0;
+                    std::size_t need = 0;
+                    for (; done < out.count; ++done) {
+                        const auto& res = out.results[done];
+                        if (res.kind == KAFKAX_DECODE_NEED_MORE) {
+                            need = res.need;
+                            break;
+                        }
+                        if (res.kind == KAFKAX_DECODE_OK && res.len <= out.cap && res.offset <= out.cap - res.len) {
+                            outs[k + done].assign(out.arena + res.offset, out.arena + res.offset + res.len);
+                            st.out_bytes += res.len;
+                        } else {
+                            ++st.errors;
+                        }
+                    }
+                    k += done;
+
+                    if (done < out.count) {
+                        ++st.retries;
+                        if (done == 0 && need <= arena.size()) {
+                            ++st.errors;
+                            ++k;
+                        } else if (need > arena.size()) {
+                            arena.resize(need);
+                        }
+                    }
+                }
+
+                st.hist->record((now_ns() - s) / static_cast<std::int64_t>(n), n);
+            }
+        }
+        st.elapsed_ns = now_ns() - t0;
+        st.msgs = opt.repeat * in.envs.size();
+    }
+
+    void report(const Options& opt, const char* mode, int threads, const Input& in,
+                std::vector<ThreadStats>& stats, std::int64_t wall_ns,
+                std::uint64_t allocs, std::uint64_t alloc_bytes) {
+        ThreadStats sum;
+        std::vector<std::uint64_t> acc(LatencyHistogram::kBuckets, 0);
+        std::int64_t busy = 0;
+        for (auto& s : stats) {
+            sum.msgs += s.msgs;
+            sum.out_bytes += s.out_bytes;
+            sum.retries += s.retries;
+            sum.errors += s.errors;
+            busy += s.elapsed_ns;
+            s.hist->add_to(acc.data());
+        }
+
+        std::int64_t q[5];
+        kafkax::percentiles(acc.data(), q);
+
+        const double n = sum.msgs ? (double)sum.msgs : 1.0;
+        const double in_per = (double)in.in_bytes / (double)std::max<std::size_t>(in.envs.size(), 1);
+        std::printf("{\"so\":\"%s\",\"symbol\":\"%s\",\"mode\":\"%s\",\"threads\":%d,\"msgs\":%llu,"
+                    "\"ns_per_msg\":%.2f,\"msg_per_s\":%.0f,\"in_bytes_per_msg\":%.1f,\"out_bytes_per_msg\":%.1f,"
+                    "\"need_more_rate\":%.6f,\"errors\":%llu,\"plugin_allocs_per_msg\":%.4f,"
+                    "\"plugin_alloc_bytes_per_msg\":%.1f,"
+                    "\"p50_ns\":%lld,\"p90_ns\":%lld,\"p99_ns\":%lld,\"p999_ns\":%lld,\"max_ns\":%lld}\n",
+                    opt.so_path.c_str(), opt.symbol.c_str(), mode, threads, (unsigned long long)sum.msgs,
+                    (double)busy / n, wall_ns > 0 ? n * 1e9 / (double)wall_ns : 0.0,
+                    in_per, (double)sum.out_bytes / n, (double)sum.retries / n,
+                    (unsigned long long)sum.errors, (double)allocs / n, (double)alloc_bytes / n,
+                    (long long)q[0], (long long)q[1], (long long)q[2], (long long)q[3], (long long)q[4]);
+        std::fflush(stdout);
+    }
+
+    template <class Fn, class Run>
+    void run_mode(const Options& opt, const char* mode, const Input& in, Fn fn, Run run) {
+        for (int threads : opt.threads) {
+            std::vector<ThreadStats> stats(static_cast<std::size_t>(threads));
+
+            const auto a0 = g_plugin_allocs.load();
+            const auto b0 = g_plugin_alloc_bytes.load();
+            const auto t0 = now_ns();
+
+            std::vector<std::thread> ths;
+            for (int t = 0; t < threads; ++t)
+                ths.emplace_back([&, t] { run(opt, in, fn, stats[static_cast<std::size_t>(t)]); });
+            for (auto& th : ths) th.join();
+
+            report(opt, mode, threads, in, stats, now_ns() - t0,
+                   g_plugin_allocs.load() - a0, g_plugin_alloc_bytes.load() - b0);
+        }
+    }
+
+    void print_usage(const char* prog) {
+        std::fprintf(stderr,
+            "Usage: %s <plugin.so> <symbol> [options]\n"
+            "  input:   --capture FILE [--topic T]          replay a capture (topic filter optional)\n"
+            "           --msgs N --size BYTES --key-size BYTES --seed S --topic T\n"
+            "                                               generated random payloads (default)\n"
+            "           --write-capture FILE                save the generated set\n"
+            "  run:     --threads 1,2,4 --repeat R --mode single|batch|both\n", prog);
+    }
+
+    bool parse_args(int argc, char** argv, Options& opt) {
+        if (argc < 3) return false;
+        opt.so_path = argv[1];
+        opt.symbol = argv[2];
+
+        bool topic_set = false;
+        for (int i = 3; i < argc; ++i) {
+            const std::string a = argv[i];
+            const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+            if (!v) return false;
+            ++i;
+
+            if (a == "--capture") opt.capture = v;
+            else if (a == "--write-capture") opt.write_capture = v;
+            else if (a == "--topic") { opt.topic = v; topic_set = true; }
+            else if (a == "--msgs") opt.msgs = std::strtoull(v, nullptr, 10);
+            else if (a == "--size") opt.size = std::strtoull(v, nullptr, 10);
+            else if (a == "--key-size") opt.key_size = std::strtoull(v, nullptr, 10);
+            else if (a == "--seed") opt.seed = std::strtoull(v, nullptr, 10);
+            else if (a == "--repeat") opt.repeat = std::max<std::uint64_t>(1, std::strtoull(v, nullptr, 10));
+            else if (a == "--mode") opt.mode = v;
+            else if (a == "--threads") {
+                std::vector<int> t;
+                if (!kafkax::placement::parse_cpu_list(v, t) || t.empty()) return false;   // "1,2,4" / "1-8"
+                t.erase(std::remove(t.begin(), t.end(), 0), t.end());
+                if (t.empty()) return false;
+                opt.threads = t;
+            } else return false;
+        }
+
+        if (!opt.capture.empty() && !topic_set) opt.topic.clear();   // capture: all topics
+        return opt.mode == "single" || opt.mode == "batch" || opt.mode == "both";
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string err;
+    Input in;
+    if (!(opt.capture.empty() ? generate(opt, in, err) : load_capture(opt, in, err))) {
+        std::fprintf(stderr, "input: %s\n", err.c_str());
+        return 1;
+    }
+
+    // same loader, ABI check and symbol resolution as Core::bind_topic
+    kafkax::DecoderRegistry registry;
+    const std::string bound = "kafkax.bench.decoder";
+    if (registry.bind(bound, opt.so_path, opt.symbol, err) != 0) {
+        std::fprintf(stderr, "bind %s:%s: %s\n", opt.so_path.c_str(), opt.symbol.c_str(), err.c_str());
+        return 1;
+    }
+    const auto route = registry.snapshot()->lookup_route(bound);
+
+    if (opt.mode != "batch")
+        run_mode(opt, "single", in, route.fn, run_single);
+
+    if (opt.mode != "single") {
+        if (route.batch_fn)
+            run_mode(opt, "batch", in, route.batch_fn, run_batch);
+        else
+            std::fprintf(stderr, "%s_batch not exported (or ABI < 3): batch mode skipped\n", opt.symbol.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,510 @@
+// kafkax_bench_e2e: end-to-end run against librdkafka's in-process mock
+// cluster. A producer thread writes a configurable message mix; a real
+// kafkax::Core consumes it through subscribe/drainTo on this thread.
+//
+// Every payload starts with the producer's steady_clock stamp (8 bytes), so
+// end-to-end latency is produce call -> drainTo on the same clock.
+//
+// Output, one JSON object per line on stdout:
+//   {"bench":"e2e", <settings>, "msgs":..,"msg_per_s":..,"mb_per_s":..,
+//    "p50_ns":..,..,"max_ns":..,"pauses":..,"partition_pauses":..,...}
+//   {"stage":"decode","topic":..,...}            (--latency-stats only)
+//   {"thread":"kfkx-decode-0","cpu_s":..,"util":..}
+#include <poll.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <librdkafka/rdkafka.h>
+#include <librdkafka/rdkafka_mock.h>
+
+#include "kafkax/core.hpp"
+#include "kafkax/latency.hpp"
+
+namespace {
+
+    using kafkax::LatencyHistogram;
+
+    inline std::int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    struct SizeClass {
+        std::size_t bytes;
+        double weight;
+    };
+
+    struct Options {
+        /* cluster and load */
+        int brokers = 3;
+        int topics = 1;
+        int partitions = 8;
+        std::uint64_t msgs = 1'000'000;
+        std::vector<SizeClass> sizes{{256, 1.0}};
+        std::size_t keys = 10000;           // distinct keys; 0 = no key
+        double key_skew = 0.0;              // Zipf exponent over keys; 0 = uniform
+        std::uint64_t rate = 0;             // msgs/s; 0 = as fast as the producer goes
+        int linger_ms = 1;
+
+        /* kafkax */
+        kafkax::Core::DecodeConfig dcfg{};
+        std::size_t drain_limit = 4096;
+        int idle_timeout_s = 10;
+    };
+
+    /* "64:70,512:25,4096:5" -> size classes with relative weights */
+    bool parse_sizes(const std::string& spec, std::vector<SizeClass>& out) {
+        std::vector<SizeClass> v;
+        const char* p = spec.c_str();
+        while (*p) {
+            char* end = nullptr;
+            const auto bytes = std::strtoull(p, &end, 10);
+            if (end == p) return false;
+            p = end;
+            double w = 1.0;
+            if (*p == ':') {
+                w = std::strtod(p + 1, &end);
+                if (end == p + 1 || w < 0) return false;
+                p = end;
+            }
+            if (*p == ',') ++p;
+            else if (*p) return false;
+            v.push_back(SizeClass{std::max<std::size_t>(bytes, sizeof(std::int64_t)), w});
+        }
+        if (v.empty()) return false;
+        out.swap(v);
+        return true;
+    }
+
+    /* Inverse-CDF sampler over n items with weight(i) = w[i]. */
+    class Sampler {
+    public:
+        explicit Sampler(const std::vector<double>& w) : cdf_(w.size()) {
+            double acc = 0;
+            for (std::size_t i = 0; i < w.size(); ++i) cdf_[i] = acc += w[i];
+            for (auto& c : cdf_) c /= acc > 0 ? acc : 1;
+        }
+
+        template <class R>
+        std::size_t operator()(R& rng) const {
+            const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+            const auto it = std::lower_bound(cdf_.begin(), cdf_.end(), u);
+            return std::min<std::size_t>(static_cast<std::size_t>(it - cdf_.begin()), cdf_.size() - 1);
+        }
+
+    private:
+        std::vector<double> cdf_;
+    };
+
+    std::string topic_name(int i) {
+        return "kafkax.e2e." + std::to_string(i);
+    }
+
+    /* ---------------- producer ---------------- */
+
+    struct Producer {
+        rd_kafka_t* rk{nullptr};
+        rd_kafka_mock_cluster_t* mock{nullptr};
+        std::string bootstraps;
+
+        ~Producer() {
+            if (rk) rd_kafka_destroy(rk);   // owns the mock cluster
+        }
+    };
+
+    bool make_producer(const Options& opt, Producer& p, std::string& err) {
+        char ebuf[512];
+        auto* conf = rd_kafka_conf_new();
+
+        const std::string brokers = std::to_string(opt.brokers);
+        const std::string linger = std::to_string(opt.linger_ms);
+        const std::pair<const char*, const char*> kv[] = {
+            {"test.mock.num.brokers", brokers.c_str()},
+            {"linger.ms", linger.c_str()},
+            {"queue.buffering.max.messages", "1000000"},
+            {"batch.num.messages", "10000"},
+            {"log_level", "3"},
+        };
+        for (const auto& [k, v] : kv) {
+            if (rd_kafka_conf_set(conf, k, v, ebuf, sizeof(ebuf)) != RD_KAFKA_CONF_OK) {
+                err = ebuf;
+                rd_kafka_conf_destroy(conf);
+                return false;
+            }
+        }
+
+        p.rk = rd_kafka_new(RD_KAFKA_PRODUCER, conf, ebuf, sizeof(ebuf));
+        if (!p.rk) {
+            err = ebuf;
+            return false;
+        }
+
+        p.mock = rd_kafka_handle_mock_cluster(p.rk);
+        if (!p.mock) {
+            err = "librdkafka built without the mock cluster";
+            return false;
+        }
+        p.bootstraps = rd_kafka_mock_cluster_bootstraps(p.mock);
+
+        for (int t = 0; t < opt.topics; ++t) {
+            const auto name = topic_name(t);
+            const auto rc = rd_kafka_mock_topic_create(p.mock, name.c_str(), opt.partitions, 1);
+            if (rc != RD_KAFKA_RESP_ERR_NO_ERROR) {
+                err = name + ": " + rd_kafka_err2str(rc);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /* Produce opt.msgs messages; keys pick the partition (default partitioner),
+     * so key_skew turns into partition skew. */
+    void produce(const Options& opt, rd_kafka_t* rk, std::atomic<bool>& stop) {
+        std::mt19937_64 rng(42);
+
+        std::vector<double> sw;
+        for (const auto& s : opt.sizes) sw.push_back(s.weight);
+        const Sampler pick_size(sw);
+
+        std::vector<double> kw(std::max<std::size_t>(opt.keys, 1));
+        for (std::size_t i = 0; i < kw.size(); ++i)
+            kw[i] = opt.key_skew > 0 ? 1.0 / std::pow((double)(i + 1), opt.key_skew) : 1.0;
+        const Sampler pick_key(kw);
+
+        std::vector<std::string> topics;
+        for (int t = 0; t < opt.topics; ++t) topics.push_back(topic_name(t));
+
+        std::size_t max_size = 0;
+        for (const auto& s : opt.sizes) max_size = std::max(max_size, s.bytes);
+        std::vector<char> payload(max_size, 'x');
+
+        const auto t0 = now_ns();
+        for (std::uint64_t i = 0; i < opt.msgs && !stop.load(std::memory_order_relaxed); ++i) {
+            if (opt.rate > 0) {
+                const auto due = t0 + static_cast<std::int64_t>(i * 1'000'000'000ull / opt.rate);
+                while (now_ns() < due) rd_kafka_poll(rk, 0);
+            }
+
+            const auto size = opt.sizes[pick_size(rng)].bytes;
+            char key[24];
+            const int key_len = opt.keys
+                ? std::snprintf(key, sizeof(key), "k%zu", pick_key(rng))
+                : 0;
+            const char* key_ptr = key_len ? key : nullptr;
+            const auto& topic = topics[i % topics.size()];
+
+            for (;;) {
+                const auto stamp = now_ns();
+                std::memcpy(payload.data(), &stamp, sizeof(stamp));
+
+                const auto rc = rd_kafka_producev(
+                    rk,
+                    RD_KAFKA_V_TOPIC(topic.c_str()),
+                    RD_KAFKA_V_VALUE(payload.data(), size),
+                    RD_KAFKA_V_KEY(key_ptr, (std::size_t)key_len),
+                    RD_KAFKA_V_MSGFLAGS(RD_KAFKA_MSG_F_COPY),
+                    RD_KAFKA_V_END);
+                if (rc == RD_KAFKA_RESP_ERR_NO_ERROR) break;
+                if (rc != RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+                    std::fprintf(stderr, "produce: %s\n", rd_kafka_err2str(rc));
+                    return;
+                }
+                rd_kafka_poll(rk, 1);
+            }
+            rd_kafka_poll(rk, 0);
+        }
+        rd_kafka_flush(rk, 30000);
+    }
+
+    /* ---------------- per-thread CPU ---------------- */
+
+    struct ThreadCpu {
+        int tid;
+        std::string name;
+        std::uint64_t ticks;   // utime + stime
+    };
+
+    std::vector<ThreadCpu> sample_threads() {
+        std::vector<ThreadCpu> out;
+        DIR* d = ::opendir("/proc/self/task");
+        if (!d) return out;
+
+        while (auto* ent = ::readdir(d)) {
+            if (ent->d_name[0] < '0' || ent->d_name[0] > '9') continue;
+
+            const std::string path = std::string("/proc/self/task/") + ent->d_name + "/stat";
+            std::FILE* f = std::fopen(path.c_str(), "r");
+            if (!f) continue;
+            char buf[1024];
+            const auto n = std::fread(buf, 1, sizeof(buf) - 1, f);
+            std::fclose(f);
+            buf[n] = '\0';
+
+            // pid (comm) state ... ; comm may contain spaces, so split at the last ')'
+            char* lp = std::strchr(buf, '(');
+            char* rp = std::strrchr(buf, ')');
+            if (!lp || !rp) continue;
+
+            ThreadCpu t{std::atoi(ent->d_name), std::string(lp + 1, rp), 0};
+            unsigned long long utime = 0, stime = 0;
+            if (std::sscanf(rp + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                            &utime, &stime) == 2)
+                t.ticks = utime + stime;
+            out.push_back(std::move(t));
+        }
+        ::closedir(d);
+        return out;
+    }
+
+    void print_thread_cpu(const std::vector<ThreadCpu>& before,
+                          const std::vector<ThreadCpu>& after,
+                          double wall_s) {
+        const double hz = (double)::sysconf(_SC_CLK_TCK);
+        for (const auto& a : after) {
+            std::uint64_t base = 0;
+            for (const auto& b : before)
+                if (b.tid == a.tid) base = b.ticks;
+            const double cpu_s = (double)(a.ticks - base) / hz;
+            if (cpu_s <= 0) continue;
+            std::printf("{\"thread\":\"%s\",\"tid\":%d,\"cpu_s\":%.3f,\"util\":%.3f}\n",
+                        a.name.c_str(), a.tid, cpu_s, wall_s > 0 ? cpu_s / wall_s : 0.0);
+        }
+    }
+
+    /* ---------------- run ---------------- */
+
+    const char* route_name(kafkax::Core::RoutePolicy p) {
+        using RP = kafkax::Core::RoutePolicy;
+        switch (p) {
+            case RP::RoundRobin:        return "rr";
+            case RP::PartitionAffinity: return "partition";
+            case RP::KeyHash:           return "key";
+            case RP::LeastLoaded:       return "leastloaded";
+        }
+        return "?";
+    }
+
+    int run(const Options& opt) {
+        std::string err;
+        Producer prod;
+        if (!make_producer(opt, prod, err)) {
+            std::fprintf(stderr, "mock cluster: %s\n", err.c_str());
+            return 1;
+        }
+
+        kafkax::Core::KafkaConfig kcfg{};
+        kcfg.bootstrap_servers = prod.bootstraps;
+        kcfg.group_id = "kafkax_bench_e2e";
+        kcfg.auto_offset_reset = "earliest";
+        kcfg.enable_auto_commit = false;
+        kcfg.extra["log_level"] = "3";
+
+        auto core = std::make_unique<kafkax::Core>(opt.dcfg, kcfg);
+
+        std::vector<std::string> topics;
+        for (int t = 0; t < opt.topics; ++t) topics.push_back(topic_name(t));
+        if (core->subscribe(topics, err) != 0) {
+            std::fprintf(stderr, "subscribe: %s\n", err.c_str());
+            return 1;
+        }
+
+        const auto cpu0 = sample_threads();
+        std::atomic<bool> stop{false};
+        std::thread producer(produce, std::cref(opt), prod.rk, std::ref(stop));
+
+        auto hist = std::make_unique<LatencyHistogram>();
+        std::vector<kafkax::Event> out;
+        out.reserve(opt.drain_limit);
+
+        std::uint64_t got = 0, bytes = 0, errors = 0;
+        std::int64_t first = 0, last = 0;
+        auto progress = now_ns();
+
+        const int efd = core->notify_fd();
+        while (got < opt.msgs) {
+            pollfd pfd{efd, POLLIN, 0};
+            (void)::poll(&pfd, 1, 100);
+            if (pfd.revents & POLLIN) {
+                std::uint64_t v;
+                while (::read(efd, &v, sizeof(v)) == (ssize_t)sizeof(v)) {}
+            }
+
+            core->drainTo(out, opt.drain_limit);
+            const auto now = now_ns();
+            if (out.empty()) {
+                if (now - progress > (std::int64_t)opt.idle_timeout_s * 1'000'000'000) {
+                    std::fprintf(stderr, "no progress for %ds, stopping at %llu/%llu\n",
+                                 opt.idle_timeout_s, (unsigned long long)got, (unsigned long long)opt.msgs);
+                    break;
+                }
+                continue;
+            }
+
+            progress = now;
+            if (!first) first = now;
+            last = now;
+            for (const auto& ev : out) {
+                if (ev.kind == kafkax::Event::Kind::Error) { ++errors; continue; }
+                const auto p = ev.payload();
+                bytes += p.size();
+                if (p.size() >= sizeof(std::int64_t)) {
+                    std::int64_t stamp;
+                    std::memcpy(&stamp, p.data(), sizeof(stamp));
+                    hist->record(now - stamp);
+                }
+            }
+            got += out.size();
+            core->recycle(out);
+        }
+
+        stop.store(true);
+        producer.join();
+        const auto cpu1 = sample_threads();
+
+        kafkax::Metrics m;
+        core->metrics(m);
+        std::vector<kafkax::LatencyRow> stages;
+        core->latency(stages);
+
+        std::int64_t q[5];
+        std::vector<std::uint64_t> acc(LatencyHistogram::kBuckets, 0);
+        hist->add_to(acc.data());
+        kafkax::percentiles(acc.data(), q);
+        const double secs = last > first ? (double)(last - first) / 1e9 : 0.0;
+
+        std::printf("{\"bench\":\"e2e\",\"brokers\":%d,\"topics\":%d,\"partitions\":%d,"
+                    "\"key_skew\":%.2f,\"rate\":%llu,\"decode_threads\":%zu,\"raw_queue\":%zu,"
+                    "\"evt_queue\":%zu,\"route\":\"%s\",\"consume_batch\":%zu,\"shared_nothing\":%s,"
+                    "\"drain_limit\":%zu,\"msgs\":%llu,\"errors\":%llu,\"msg_per_s\":%.0f,\"mb_per_s\":%.2f,"
+                    "\"p50_ns\":%lld,\"p90_ns\":%lld,\"p99_ns\":%lld,\"p999_ns\":%lld,\"max_ns\":%lld,"
+                    "\"pauses\":%llu,\"partition_pauses\":%llu,\"kafka_errors\":%llu,\"steals\":%llu}\n",
+                    opt.brokers, opt.topics, opt.partitions, opt.key_skew, (unsigned long long)opt.rate,
+                    opt.dcfg.decode_threads, opt.dcfg.raw_queue_size, opt.dcfg.evt_queue_size,
+                    route_name(opt.dcfg.route_policy), opt.dcfg.consume_batch,
+                    opt.dcfg.shared_nothing ? "true" : "false", opt.drain_limit,
+                    (unsigned long long)got, (unsigned long long)errors,
+                    secs > 0 ? (double)got / secs : 0.0, secs > 0 ? (double)bytes / secs / 1e6 : 0.0,
+                    (long long)q[0], (long long)q[1], (long long)q[2], (long long)q[3], (long long)q[4],
+                    (unsigned long long)m.pauses, (unsigned long long)m.partition_pauses,
+                    (unsigned long long)m.kafka_errors, (unsigned long long)m.steals);
+
+        for (const auto& r : stages) {
+            std::printf("{\"stage\":\"%s\",\"topic\":\"%s\",\"count\":%llu,\"p50_ns\":%lld,"
+                        "\"p90_ns\":%lld,\"p99_ns\":%lld,\"p999_ns\":%lld,\"max_ns\":%lld}\n",
+                        kafkax::latency_stage_name(r.stage), core->topic_name(r.topic_id).c_str(),
+                        (unsigned long long)r.count, (long long)r.p50, (long long)r.p90,
+                        (long long)r.p99, (long long)r.p999, (long long)r.max);
+        }
+
+        print_thread_cpu(cpu0, cpu1, secs);
+
+        core.reset();   // consumer goes before the cluster it talks to
+        return got == opt.msgs ? 0 : 2;
+    }
+
+    void print_usage(const char* prog) {
+        std::fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  load:   --msgs N --brokers N --topics N --partitions N\n"
+            "          --sizes 64:70,512:25,4096:5   payload sizes with weights\n"
+            "          --keys N (0 = unkeyed) --key-skew S (Zipf exponent)\n"
+            "          --rate MSGS_PER_S (0 = max) --linger-ms N\n"
+            "  kafkax: --decode-threads N --raw-queue N --evt-queue N\n"
+            "          --route rr|partition|key|leastloaded --consume-batch N\n"
+            "          --wait blocking|spin|busypoll --zero-copy --shared-nothing\n"
+            "          --work-stealing --partition-hwm N --latency-stats\n"
+            "          --drain-limit N --idle-timeout S\n", prog);
+    }
+
+    bool parse_args(int argc, char** argv, Options& opt) {
+        auto& d = opt.dcfg;
+        for (int i = 1; i < argc; ++i) {
+            const std::string a = argv[i];
+            auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+            auto num = [&](auto& dst) {
+                const char* v = next();
+                if (!v) return false;
+                dst = static_cast<std::remove_reference_t<decltype(dst)>>(std::strtod(v, nullptr));
+                return true;
+            };
+
+            bool ok = true;
+            if (a == "--msgs") ok = num(opt.msgs);
+            else if (a == "--brokers") ok = num(opt.brokers);
+            else if (a == "--topics") ok = num(opt.topics);
+            else if (a == "--partitions") ok = num(opt.partitions);
+            else if (a == "--sizes") { const char* v = next(); ok = v && parse_sizes(v, opt.sizes); }
+            else if (a == "--keys") ok = num(opt.keys);
+            else if (a == "--key-skew") ok = num(opt.key_skew);
+            else if (a == "--rate") ok = num(opt.rate);
+            else if (a == "--linger-ms") ok = num(opt.linger_ms);
+            else if (a == "--decode-threads") ok = num(d.decode_threads);
+            else if (a == "--raw-queue") ok = num(d.raw_queue_size);
+            else if (a == "--evt-queue") ok = num(d.evt_queue_size);
+            else if (a == "--consume-batch") ok = num(d.consume_batch);
+            else if (a == "--partition-hwm") ok = num(d.partition_high_watermark);
+            else if (a == "--drain-limit") ok = num(opt.drain_limit);
+            else if (a == "--idle-timeout") ok = num(opt.idle_timeout_s);
+            else if (a == "--zero-copy") d.zero_copy = true;
+            else if (a == "--shared-nothing") d.shared_nothing = true;
+            else if (a == "--work-stealing") d.work_stealing = true;
+            else if (a == "--latency-stats") d.latency_stats = true;
+            else if (a == "--route") {
+                const std::string v = next() ? argv[i] : "";
+                using RP = kafkax::Core::RoutePolicy;
+                if (v == "rr") d.route_policy = RP::RoundRobin;
+                else if (v == "partition") d.route_policy = RP::PartitionAffinity;
+                else if (v == "key") d.route_policy = RP::KeyHash;
+                else if (v == "leastloaded") d.route_policy = RP::LeastLoaded;
+                else ok = false;
+            } else if (a == "--wait") {
+                const std::string v = next() ? argv[i] : "";
+                using WS = kafkax::Core::WaitStrategy;
+                if (v == "blocking") d.wait_strategy = WS::Blocking;
+                else if (v == "spin") d.wait_strategy = WS::SpinThenPark;
+                else if (v == "busypoll") d.wait_strategy = WS::BusyPoll;
+                else ok = false;
+            } else ok = false;
+
+            if (!ok) {
+                std::fprintf(stderr, "bad argument: %s\n", a.c_str());
+                return false;
+            }
+        }
+        if (opt.brokers < 1 || opt.topics < 1 || opt.partitions < 1 || d.decode_threads < 1) return false;
+        return true;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    opt.dcfg.decode_threads = 4;
+    opt.dcfg.raw_queue_size = 32768;
+    opt.dcfg.evt_queue_size = 32768;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+    }
+    if (!parse_args(argc, argv, opt)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    return run(opt);
+}
@@ -121,19 +121,20 @@ namespace {
         }
     }
 
-    void print_event(const kafkax::Event& ev) {
+    void print_event(const kafkax::Core& core, const kafkax::Event& ev) {
         if (ev.kind == kafkax::Event::Kind::Error) {
-            std::cerr << "[ERROR] topic=" << ev.topic
+            std::cerr << "[ERROR] topic=" << core.topic_name(ev.topic_id)
                       << " msg=" << ev.err_msg << std::endl;
             return;
         }
 
-        std::cout << "[DATA] topic=" << ev.topic
-                  << " len=" << ev.bytes.size();
+        std::cout << "[DATA] topic=" << core.topic_name(ev.topic_id)
+                  << " len=" << ev.payload().size();
 
-        if (!ev.bytes.empty()) {
+        if (!ev.payload().empty()) {
+            auto p = ev.payload();
             std::cout << " payload="
-                      << std::string(ev.bytes.begin(), ev.bytes.end());
+                      << std::string(p.begin(), p.end());
         }
 
         std::cout << std::endl;
@@ -206,6 +207,9 @@ int main(int argc, char** argv) {
 
     constexpr std::size_t LIMIT = 4096;
 
+    std::vector<kafkax::Event> out;
+    out.reserve(LIMIT);
+
     while (g_running) {
 
         // Wait until efd readable (or timeout so we can print stats / respond to signal)
@@ -230,21 +234,23 @@ int main(int argc, char** argv) {
 
         // Drain batches; Core will re-notify if backlog remains
         for (;;) {
-            std::vector<kafkax::Event> out;
-            out.reserve(LIMIT);
-
             core.drainTo(out, LIMIT);
             if (out.empty()) break;
 
             for (const auto& ev : out) {
                 stats.on_event(ev);
-                // print_event(ev);
+                // print_event(core, ev);
             }
 
             stats.maybe_print();
 
             // If we hit LIMIT, likely backlog remains; loop again immediately.
-            if (out.size() < LIMIT) break;
+            const bool full = out.size() >= LIMIT;
+
+            // Return buffers to the decode workers (also clears out)
+            core.recycle(out);
+
+            if (!full) break;
         }
     }
 
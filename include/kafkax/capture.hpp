@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace kafkax {
+
+    /* Capture file: recorded Kafka messages for offline replay and benchmarks.
+     *
+     *   "KFKXCAP1"                                   8-byte magic
+     *   then per message, host byte order:
+     *     u32 topic_len, u32 key_len, u32 payload_len, i32 partition,
+     *     i64 offset, i64 timestamp_ms (-1 = none)   32-byte header
+     *     topic, key, payload bytes                  no padding
+     */
+    struct CaptureRecord {
+        std::string_view topic;
+        std::int32_t partition{0};
+        std::int64_t offset{0};
+        std::int64_t timestamp_ms{-1};
+        std::span<const std::uint8_t> key;
+        std::span<const std::uint8_t> payload;
+    };
+
+    /* Read-only mapping of a capture file; records are views into it and
+     * stay valid until the reader is closed or destroyed. */
+    class CaptureReader {
+    public:
+        CaptureReader() = default;
+        ~CaptureReader();
+
+        CaptureReader(const CaptureReader&) = delete;
+        CaptureReader& operator=(const CaptureReader&) = delete;
+
+        bool open(const std::string& path, std::string& err);
+        void close() noexcept;
+
+        /* false at the end of the file; a truncated last record also ends it */
+        bool next(CaptureRecord& out) noexcept;
+        void rewind() noexcept { pos_ = kMagicLen; }
+
+        std::size_t size_bytes() const noexcept { return len_; }
+
+    private:
+        static constexpr std::size_t kMagicLen = 8;
+
+        const std::uint8_t* base_{nullptr};
+        std::size_t len_{0};
+        std::size_t pos_{0};
+    };
+
+    /* Buffered appender for capture files. */
+    class CaptureWriter {
+    public:
+        CaptureWriter() = default;
+        ~CaptureWriter();
+
+        CaptureWriter(const CaptureWriter&) = delete;
+        CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+        bool open(const std::string& path, std::string& err);
+        bool append(const CaptureRecord& rec) noexcept;
+        bool close(std::string& err);
+
+    private:
+        std::FILE* f_{nullptr};
+        std::string path_;
+        bool ok_{true};
+    };
+
+} // namespace kafkax
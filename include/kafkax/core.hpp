@@ -1,25 +1,40 @@
 #pragma once
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <string>
 #include <thread>
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <unordered_map>
+#include <utility>
 
 #include <librdkafka/rdkafka.h>
 
 #include "kafkax/event.h"
+#include "kafkax/decode_stats.hpp"
 #include "kafkax/decoder_registry.hpp"
+#include "kafkax/flight_recorder.hpp"
+#include "kafkax/latency.hpp"
+#include "kafkax/message_source.hpp"
+#include "kafkax/metrics.hpp"
+#include "kafkax/placement.hpp"
+#include "kafkax/topic_table.hpp"
 
 namespace kafkax {
 
     namespace detail {
+        /* Capacity is rounded up to a power of two. Each side keeps a cached copy
+         * of the other side's index and only reloads it when the cache says
+         * full/empty, so the shared cache lines move once per batch.
+         * A non-default MemPolicy maps the slots with placement::alloc_pages. */
         template <class T>
         class SPSCRing {
         public:
-            explicit SPSCRing(std::size_t capacity);
+            explicit SPSCRing(std::size_t capacity, const placement::MemPolicy& mem = {});
 
             ~SPSCRing();
 
@@ -29,15 +44,64 @@ namespace kafkax {
             bool try_push(T&& v);
             bool try_pop(T& out);
 
+            /* Bulk: move up to items.size() elements; returns how many moved.
+             * try_push_n moves from the front of items, try_pop_n fills out from the front. */
+            std::size_t try_push_n(std::span<T> items);
+            std::size_t try_pop_n(std::span<T> out);
+
             std::size_t capacity() const noexcept { return cap_; }
             std::size_t size() const noexcept;
 
         private:
             const std::size_t cap_;
+            const std::size_t mask_;
+            const placement::MemPolicy mem_;
             T* buf_{nullptr};
 
             alignas(64) std::atomic<std::uint64_t> head_{0}; // consumer
+            std::uint64_t tail_cache_{0};                     // consumer's last view of tail_
+
             alignas(64) std::atomic<std::uint64_t> tail_{0}; // producer
+            std::uint64_t head_cache_{0};                     // producer's last view of head_
+        };
+
+        /* How a thread waits for / signals progress on a ring.
+         * - Blocking:     park in atomic_wait straight away, notify on every signal
+         * - SpinThenPark: spin first; signal only issues a (futex) notify when a waiter is parked
+         * - BusyPoll:     never park, never notify; for threads pinned to dedicated cores
+         */
+        enum class WaitStrategy : std::uint8_t {
+            Blocking = 0,
+            SpinThenPark = 1,
+            BusyPoll = 2
+        };
+
+        /* Epoch counter shared by a ring's producer and consumer. */
+        class WaitPoint {
+        public:
+            WaitPoint(WaitStrategy strategy, std::uint32_t spin_iterations) noexcept
+                : strategy_(strategy), spins_(spin_iterations) {}
+
+            WaitPoint(const WaitPoint&) = delete;
+            WaitPoint& operator=(const WaitPoint&) = delete;
+
+            /* Snapshot to pass to wait(); take it before re-checking the ring. */
+            std::uint64_t prepare() const noexcept { return epoch_.load(std::memory_order_seq_cst); }
+
+            /* Returns once the epoch moved past seen (BusyPoll/SpinThenPark may return early). */
+            void wait(std::uint64_t seen) noexcept;
+
+            void signal() noexcept;
+
+            /* Shutdown: wake every waiter; later wait() calls return immediately. */
+            void close() noexcept;
+
+        private:
+            alignas(64) std::atomic<std::uint64_t> epoch_{0};
+            std::atomic<std::uint32_t> parked_{0};
+            std::atomic<bool> closed_{false};
+            const WaitStrategy strategy_;
+            const std::uint32_t spins_;
         };
     } // namespace kafkax::detail
 
@@ -49,9 +113,37 @@ namespace kafkax {
             bool enable_auto_commit{true};
             std::string auto_offset_reset{"latest"};
 
+            /* At-least-once: commit an offset only after it (and every earlier
+             * offset of its partition) was returned by drainTo. Overrides
+             * enable_auto_commit; commits are async, every commit_interval_ms. */
+            bool commit_on_drain{false};
+            std::uint32_t commit_interval_ms{1000};
+
+            /* statistics.interval.ms; 0 = no librdkafka stats. When set and
+             * prometheus_file is non-empty, the metrics are rewritten there
+             * on every stats tick (textfile-collector style). */
+            std::uint32_t stats_interval_ms{0};
+            std::string prometheus_file{};
+
             std::unordered_map<std::string, std::string> extra{};
         };
 
+        /* How consumer_loop picks a decode worker for each message.
+         * - RoundRobin:        spread evenly, no ordering guarantee
+         * - PartitionAffinity: same (topic, partition) -> same worker, keeps partition order
+         * - KeyHash:           same key -> same worker, keeps per-key order
+         *                      (messages without a key fall back to PartitionAffinity)
+         * - LeastLoaded:       shallowest raw queue, no ordering guarantee
+         */
+        enum class RoutePolicy : std::uint8_t {
+            RoundRobin = 0,
+            PartitionAffinity = 1,
+            KeyHash = 2,
+            LeastLoaded = 3
+        };
+
+        using WaitStrategy = detail::WaitStrategy;
+
         struct DecodeConfig {
             std::size_t decode_threads{4};
             std::size_t raw_queue_size{8192};
@@ -59,14 +151,137 @@ namespace kafkax {
 
             double high_watermark_ratio{0.9};
             double low_watermark_ratio{0.5};
+
+            /* Event-side backpressure: decoded-but-undrained events (ratios of
+             * evt_queue_size), and how long q may go without draining while
+             * events are pending before Kafka is paused (0 disables). */
+            double evt_high_watermark_ratio{0.9};
+            double evt_low_watermark_ratio{0.5};
+            std::uint32_t drain_stall_ms{1000};
+
+            /* Per-partition pause/resume: a partition with more than
+             * partition_high_watermark messages waiting for decode is paused on
+             * its own and resumed at partition_low_watermark (0 -> high / 2).
+             * 0 disables; the global watermarks above still apply. */
+            std::size_t partition_high_watermark{0};
+            std::size_t partition_low_watermark{0};
+
+            RoutePolicy route_policy{RoutePolicy::RoundRobin};
+
+            /* Passthrough bindings skip the decoder and keep the rdkafka message
+             * alive in the Event (see Event::payload()) instead of copying it. */
+            bool zero_copy{false};
+
+            /* consume_batch > 1: pull up to that many messages per
+             * rd_kafka_consume_batch_queue() call and hand them off in bulk. */
+            std::size_t consume_batch{0};
+            int consume_timeout_ms{100};
+
+            /* Catch-up profile: after a seek, consume up to catchup_batch
+             * messages per call until every sought partition is within
+             * catchup_batch of its high watermark. 0 = off. */
+            std::size_t catchup_batch{0};
+
+            /* Idle decode threads take whole batches from a lane whose raw queue
+             * holds at least steal_threshold messages and decode them alongside
+             * the lane's owner. Every batch is published to its lane's event ring
+             * in the order it was popped, so per-lane (and thus per-partition
+             * under affinity routing) order holds. */
+            bool work_stealing{false};
+            std::size_t steal_threshold{256};
+
+            /* consumer/decode thread handoff; spin_iterations applies to SpinThenPark */
+            WaitStrategy wait_strategy{WaitStrategy::Blocking};
+            std::uint32_t spin_iterations{4000};
+
+            /* Shared-nothing: each assigned partition's rdkafka queue is forwarded
+             * to one of decode_threads queues; that thread consumes and decodes in
+             * place, with no raw ring hop. The consumer thread only serves
+             * rebalances and pause/resume. Partitions are spread evenly on every
+             * assignment. Not combinable with partition_high_watermark or
+             * commit_on_drain; route_policy and work_stealing do not apply. */
+            bool shared_nothing{false};
+
+            /* CPU placement, taskset syntax ("0-3,8"); empty = not pinned.
+             * Decoder i is pinned to the i-th CPU of decoder_cpus (wrapping).
+             * numa_local puts each lane's rings on its decoder's node;
+             * huge_pages backs them with 2MB pages (THP if none are reserved). */
+            std::string consumer_cpus{};
+            std::string decoder_cpus{};
+            bool numa_local{true};
+            bool huge_pages{false};
+
+            /* Per-topic, per-stage latency histograms (see LatencyStage):
+             * a few clock reads per batch and a counter bump per message. */
+            bool latency_stats{false};
+
+            /* Per-(topic, binding) decoder cost: calls, time, bytes, NEED_MORE
+             * retries, errors (see decoder_costs). Two clock reads per decoder call. */
+            bool decoder_stats{true};
+
+            /* Flight recorder: each decode worker keeps its last N messages
+             * (position, payload prefix, outcome, timing) for .kfkx.recent.
+             * At least 64, rounded up to a power of two; 0 disables. */
+            std::size_t flight_recorder{256};
+        };
+
+        /* Per-partition accounting (partition_high_watermark > 0 or commit_on_drain).
+         * Created by the consumer thread and never freed before stop(), so
+         * decode workers and the drain thread may hold raw pointers to it. */
+        struct PartitionState {
+            std::string topic;
+            std::uint32_t topic_id{0};
+            std::int32_t partition{0};
+
+            std::atomic<std::size_t> depth{0};        // dispatched, not yet decoded
+            std::atomic<bool> resume_wanted{false};   // set by workers crossing the low watermark
+
+            bool paused{false};                       // consumer thread only
+            std::size_t batch_count{0};               // consumer thread only (dispatch scratch)
+
+            /* commit_on_drain: dispatched offsets in order, flagged once drained.
+             * ack_next is the committable position (last contiguous drained + 1). */
+            std::mutex ack_mu;
+            std::deque<std::pair<std::int64_t, bool>> ack_window;
+            std::int64_t ack_next{-1};
+            bool ack_dirty{false};
+            std::vector<std::int64_t> ack_stage;      // consumer thread only (dispatch scratch)
         };
 
+        /* Owning handle to one rdkafka message; stored by value in the raw rings. */
         struct RawMsg {
             rd_kafka_message_t* msg{nullptr};
+            PartitionState* part{nullptr};
+            std::uint32_t gen{0};       // seek generation at dispatch
+            std::int64_t poll_ns{0};    // latency_stats only
+
+            RawMsg() = default;
+            explicit RawMsg(rd_kafka_message_t* m, PartitionState* p = nullptr,
+                            std::uint32_t g = 0, std::int64_t polled = 0) noexcept
+                : msg(m), part(p), gen(g), poll_ns(polled) {}
+
+            RawMsg(RawMsg&& o) noexcept
+                : msg(std::exchange(o.msg, nullptr)), part(std::exchange(o.part, nullptr)),
+                  gen(o.gen), poll_ns(o.poll_ns) {}
+            RawMsg& operator=(RawMsg&& o) noexcept {
+                if (this != &o) {
+                    reset();
+                    msg = std::exchange(o.msg, nullptr);
+                    part = std::exchange(o.part, nullptr);
+                    gen = o.gen;
+                    poll_ns = o.poll_ns;
+                }
+                return *this;
+            }
+
+            RawMsg(const RawMsg&) = delete;
+            RawMsg& operator=(const RawMsg&) = delete;
 
-            ~RawMsg() {
+            ~RawMsg() { reset(); }
+
+            void reset() noexcept {
                 if (msg) {
-                    rd_kafka_message_destroy(msg);
+                    release_message(msg);
                     msg = nullptr;
                 }
             }
@@ -89,6 +304,40 @@ namespace kafkax {
         int subscribe(const std::vector<std::string>& topics,
                       std::string& err);
 
+        /* Feed the pipeline from src instead of Kafka (see make_source); call
+         * before subscribe, whose topics then select what src delivers. Seeks,
+         * pause/resume and commits do not apply, so shared_nothing,
+         * partition_high_watermark and commit_on_drain are rejected, and
+         * set_conf fails from then on. */
+        int set_source(std::unique_ptr<MessageSource> src, std::string& err);
+
+        /* A non-Kafka source ran dry and drainTo has returned all it produced. */
+        bool source_finished() const noexcept {
+            return source_done_.load(std::memory_order_acquire) &&
+                   drained_.load(std::memory_order_relaxed) == consumed_.load(std::memory_order_relaxed);
+        }
+
+        /* ----- replay ----- */
+        struct SeekTarget {
+            std::string topic;
+            std::int32_t partition{0};
+            std::int64_t offset{RD_KAFKA_OFFSET_BEGINNING};
+        };
+
+        /* Reposition assigned partitions. The seek is applied by the consumer
+         * thread between batches; events of the sought partitions that were
+         * already in flight are dropped by drainTo, so the next drain starts
+         * at the new position. Returns -1 (err) if not subscribed yet. */
+        int seek_to_offsets(const std::vector<SeekTarget>& targets, std::string& err);
+
+        /* Seek every assigned partition of topics (all when empty) to the first
+         * message with timestamp >= ts_ms (rd_kafka_offsets_for_times); blocks
+         * the caller for the broker lookup only. */
+        int seek_to_timestamp(std::int64_t ts_ms,
+                              const std::vector<std::string>& topics,
+                              std::string& err,
+                              int timeout_ms = 5000);
+
         /* ----- control plane (decoder binding) ----- */
         int bind_topic(const std::string& topic,
                const std::string& so_path,
@@ -105,22 +354,194 @@ namespace kafkax {
         bool get_topic_decoder(const std::string& topic,
                                DecoderRegistry::BindingInfo& out) const;
 
+        /* Any binding by id (DecoderCost::binding), including replaced ones. */
+        bool binding_info(std::uint32_t id, DecoderRegistry::BindingInfo& out) const {
+            return registry_.binding_info(id, out);
+        }
+
+        /* Changes whenever a binding changes (see DecoderRegistry::generation). */
+        std::uint64_t binding_generation() const noexcept { return registry_.generation(); }
+
+        /* Batches taken by idle workers from other lanes (work stealing). */
+        std::uint64_t steal_count() const noexcept { return steals_.load(std::memory_order_relaxed); }
+
+        /* ----- topic ids (Event::topic_id) ----- */
+        std::uint32_t topic_id(const std::string& topic) { return topics_.intern(topic); }
+        const std::string& topic_name(std::uint32_t id) const { return topics_.name(id); }
+
         /* ----- data plane ----- */
         void drainTo(std::vector<Event>& out, std::size_t limit = 4096);
 
+        /* Hand drained events back to the decode workers' pools so their
+         * topic/key/bytes capacity is reused. Must be called from the drain
+         * thread; evs is left empty. */
+        void recycle(std::vector<Event>& evs);
+
         int notify_fd() const noexcept { return efd_; }
 
+        /* Counters, queue depths and the latest librdkafka stats. Any thread. */
+        void metrics(Metrics& out) const;
+
+        /* Merged latency percentiles, one row per (topic, stage) with samples.
+         * Empty unless DecodeConfig::latency_stats. Any thread. */
+        void latency(std::vector<LatencyRow>& out) const;
+
+        /* Decoder cost merged across workers, one row per (topic, binding) that
+         * has run. Empty unless DecodeConfig::decoder_stats. Any thread. */
+        void decoder_costs(std::vector<DecoderCost>& out) const;
+
+        /* Flight recorder contents for topic (empty = all topics), merged
+         * across workers, oldest first. Any thread. */
+        void recent(const std::string& topic, std::vector<FlightRecord>& out) const;
+
+        /* recent("") to path as text (see write_flight_records). */
+        bool dump_recent(const std::string& path, std::string& err) const;
+
     private:
+#if defined(KAFKAX_BENCH_ACCESS)
+        friend struct CoreBench;   // bench/kafkax_bench.cpp only: drives decode and the event rings directly
+#endif
+#if defined(KAFKAX_TEST_ACCESS)
+        friend struct CoreTest;    // tests/ only: drives dispatch and the raw rings directly
+#endif
+
+        static constexpr std::size_t kDecodeBatch = 64;   // raw msgs popped per decode iteration
+        static constexpr std::size_t kDrainBatch = 256;   // events popped per ring access in drainTo
+        static constexpr std::size_t kDecodeArena = 64 * 1024;   // batch decode arena block
+
         int apply_kafka_config(const KafkaConfig& kafka_cfg, std::string& err);
 
         void start();
         void stop();
 
+        /* stop(), threads joined: drop every queued message and event so no
+         * rdkafka message outlives rk_ */
+        void release_queued();
+
         void consumer_loop();
+        void pin_decoder(std::size_t worker_id) const;
+        placement::MemPolicy lane_mem(std::size_t lane) const;
+
         void decode_loop(std::size_t worker_id);
+        void shard_loop(std::size_t worker_id);
+
+        void forward_partitions(const rd_kafka_topic_partition_list_t* parts, bool attach);
 
         void maybe_pause();
 
+        bool below_low_watermarks() const noexcept;
+
+        bool drain_stalled() const noexcept;
+
+        PartitionState* partition_state(const rd_kafka_message_t* msg);
+
+        void pause_hot_partitions();
+
+        void resume_cool_partitions();
+
+        void release_partition_depth(RawMsg* raws, std::size_t n);
+
+        rd_kafka_topic_partition_list_t* unpaused_assignment() const;
+
+        void ack_drained(const Event* evs, std::size_t n);
+
+        void commit_acked(bool async);
+
+        void reset_ack_windows();
+
+        void apply_pending_seeks();
+
+        bool caught_up();
+
+        bool seek_stale(const Event& ev) const noexcept;
+
+        std::size_t dispatch(rd_kafka_message_t** msgs, std::size_t n);
+
+        /* per-worker buffers for batch decode (ABI v3) */
+        struct DecodeScratch {
+            std::vector<RawMsg> raws;
+            std::vector<std::unique_ptr<Event>> evs;
+
+            /* rkt -> topic id; a handful of topics, so a linear scan beats hashing */
+            struct TopicSlot {
+                const rd_kafka_topic_t* rkt;
+                std::uint32_t id;
+                const std::string* name;
+            };
+            std::vector<TopicSlot> topics;
+            std::vector<const std::string*> names;   // per message in the current batch
+            std::vector<std::uint32_t> lat_topics;   // latency_stats: topic id per message
+            std::vector<std::size_t> flight_pos;     // flight recorder slot per message
+
+            /* worker-local router snapshot, refreshed when the registry generation moves;
+             * routes are memoised per topic id so steady state is one array index */
+            std::shared_ptr<const Router> router;
+            std::uint64_t router_gen{~std::uint64_t{0}};
+            std::vector<Route> routes;
+            std::vector<std::uint8_t> route_known;
+            std::vector<DecodeCostRecorder::Slot*> costs;   // decoder_stats, per topic id
+
+            std::vector<kafkax_envelope_t> envs;
+            std::vector<kafkax_decode_result_t> results;
+        };
+
+        /* Batch decode output of one worker (that worker only). Calls append to
+         * the current block; its events borrow their slices (Event::arena). */
+        struct ArenaPool {
+            std::vector<std::unique_ptr<ArenaBlock>> blocks;
+            std::size_t cur{0};    // block being appended to
+            std::size_t used{0};   // bytes of it already handed out
+        };
+
+        /* a block with at least need free bytes, made current: the current one if
+         * it has room, else one no event refers to any more, else a new one */
+        ArenaBlock& arena_room(ArenaPool& pool, std::size_t need);
+
+        static void init_scratch(DecodeScratch& scratch);
+
+        std::size_t decode_batch(std::size_t lane, std::size_t self, DecodeScratch& scratch);
+
+        static constexpr std::uint64_t kNoTicket = ~std::uint64_t{0};
+
+        void decode_raws(std::size_t lane, std::size_t self, DecodeScratch& scratch, std::size_t n,
+                         std::uint64_t ticket = kNoTicket);
+
+        bool wait_publish_turn(std::size_t lane, std::uint64_t ticket) const noexcept;
+
+        bool try_steal(std::size_t self, DecodeScratch& scratch);
+
+        void wake_thief(std::size_t lane);
+
+        void refresh_router(DecodeScratch& scratch);
+
+        const Route& route_for(DecodeScratch& scratch,
+                               std::uint32_t topic_id,
+                               const std::string& topic);
+
+        const std::string* prepare_event(const rd_kafka_message_t* msg,
+                                         Event& ev,
+                                         DecodeScratch& scratch);
+
+        DecodeCostRecorder::Slot* cost_slot(std::size_t self,
+                                            DecodeScratch& scratch,
+                                            std::uint32_t topic_id,
+                                            const Route& route);
+
+        void decode_message(RawMsg& raw,
+                            Event& ev,
+                            kafkax_decode_fn fn,
+                            const std::string& topic,
+                            DecodeCostRecorder::Slot* cost);
+
+        void decode_run(std::size_t self,
+                        RawMsg* raws,
+                        std::unique_ptr<Event>* evs,
+                        const std::string* const* names,
+                        std::size_t n,
+                        kafkax_decode_batch_fn batch_fn,
+                        DecodeScratch& scratch,
+                        DecodeCostRecorder::Slot* cost);
+
         std::size_t next_worker(const rd_kafka_message_t* msg);
 
     private:
@@ -133,27 +554,121 @@ namespace kafkax {
         bool kafka_conf_ok_{true};
         std::string kafka_conf_err_;
 
+        /* Where consumer_loop polls from: Kafka (set by subscribe, reset in stop()
+         * before rk_ goes) or set_source(). Declared ahead of the rings so a
+         * replay mapping outlives zero-copy events still referring to it. */
+        std::unique_ptr<MessageSource> source_;
+        std::atomic<bool> source_done_{false};
+
         std::atomic<bool> stop_{false};
 
         std::thread consumer_th_;
         std::vector<std::thread> workers_;
 
+        /* per decode worker; ahead of the rings, whose events may borrow from them */
+        std::vector<std::unique_ptr<ArenaPool>> arenas_;
+
         /* Queues */
-        std::vector<std::unique_ptr<detail::SPSCRing<std::unique_ptr<RawMsg>>>> raw_qs_;
+        std::vector<std::unique_ptr<detail::SPSCRing<RawMsg>>> raw_qs_;
         std::vector<std::unique_ptr<detail::SPSCRing<std::unique_ptr<Event>>>> evt_qs_;
 
-        /* Epochs for atomic_wait */
-        std::vector<std::unique_ptr<std::atomic<std::uint64_t>>> raw_epochs_;
+        /* Event pool: drain thread -> decode worker return path */
+        std::vector<std::unique_ptr<detail::SPSCRing<std::unique_ptr<Event>>>> free_qs_;
+        std::vector<std::unique_ptr<Event>> drain_shells_;  // drain thread only
+        std::vector<std::unique_ptr<Event>> drain_batch_;   // drain thread only
+
+        /* Per-lane wait points (raw ring producer <-> consumer) */
+        std::vector<std::unique_ptr<detail::WaitPoint>> raw_epochs_;
+
+        /* metrics */
+        std::atomic<std::uint64_t> consumed_{0};
+        std::atomic<std::uint64_t> drained_{0};
+        std::atomic<std::uint64_t> decode_errors_{0};
+        std::atomic<std::uint64_t> kafka_errors_{0};
+        std::atomic<std::uint64_t> pauses_{0};
+        std::atomic<std::uint64_t> part_pauses_{0};
+        std::atomic<std::uint64_t> seek_errors_{0};
+        mutable std::mutex stats_mu_;   // guards kafka_stats_, last_error_
+        KafkaStats kafka_stats_;
+        bool has_kafka_stats_{false};
+        std::string last_error_;
+        std::string prometheus_file_;
+
+        void note_error(std::string what);
+        void on_stats(const char* json, std::size_t len);
+
+        /* latency_stats: one recorder per decode worker, one for the drain thread */
+        std::vector<std::unique_ptr<LatencyRecorder>> lat_workers_;
+        LatencyRecorder lat_drain_;
+        std::int64_t wall_minus_mono_ns_{0};   // maps poll stamps onto broker (wall) time
+
+        /* decoder_stats: one recorder per decode worker */
+        std::vector<std::unique_ptr<DecodeCostRecorder>> cost_workers_;
+
+        /* flight_recorder: one ring per decode worker */
+        std::vector<std::unique_ptr<FlightRecorder>> flight_;
+
+        /* parsed DecodeConfig::consumer_cpus / decoder_cpus */
+        std::vector<int> consumer_cpus_;
+        std::vector<int> decoder_cpus_;
+
+        /* shared_nothing: per-thread rdkafka queues the partition queues forward to */
+        std::vector<rd_kafka_queue_t*> shard_qs_;
+        std::vector<std::vector<RawMsg>> dispatch_stage_;   // consumer thread only, per worker
+
+        /* Work stealing: lane_mu_ is held only to pop a batch and take the lane's
+         * next ticket; the batch is decoded unlocked and its events are pushed
+         * once published reaches that ticket, so a lane's order holds while
+         * several threads decode it. */
+        struct LaneOrder {
+            std::uint64_t popped{0};                                 // under lane_mu_
+            alignas(64) std::atomic<std::uint64_t> published{0};     // next ticket to push
+        };
+        std::vector<std::unique_ptr<std::mutex>> lane_mu_;
+        std::vector<std::unique_ptr<LaneOrder>> lane_order_;
+        std::atomic<std::uint64_t> steals_{0};
+
+        /* Event-ring wait points: decode worker parks on a full ring, drainTo signals */
+        std::vector<std::unique_ptr<detail::WaitPoint>> evt_waits_;
 
         /* Global counters for watermarks */
         std::atomic<std::size_t> total_raw_{0};
+        std::atomic<std::size_t> total_evt_{0};
+        std::atomic<std::int64_t> last_drain_ns_{0};
 
         std::size_t high_watermark_;
         std::size_t low_watermark_;
+        std::size_t evt_high_watermark_;
+        std::size_t evt_low_watermark_;
 
         std::atomic<bool> paused_{false};
         std::atomic<bool> resume_requested_{false};
 
+        /* Per-partition backpressure (consumer thread owns the index) */
+        std::size_t part_low_watermark_{0};
+        std::vector<std::unique_ptr<PartitionState>> part_states_;
+        std::vector<std::pair<const rd_kafka_topic_t*, std::vector<PartitionState*>>> part_index_;
+        std::vector<PartitionState*> part_touched_;
+        std::atomic<bool> part_resume_requested_{false};
+        mutable std::mutex part_mu_;   // guards part_states_ growth vs drain-side lookups
+
+        /* commit_on_drain */
+        bool ack_commit_{false};
+        std::uint32_t commit_interval_ms_{1000};
+        std::int64_t last_commit_ns_{0};                          // consumer thread only
+        std::vector<std::vector<PartitionState*>> drain_parts_;   // drain thread only: [topic_id][partition]
+
+        /* seek: requests queued for the consumer thread; seek_floor_ holds, per
+         * [topic_id][partition], the generation of its last seek */
+        std::mutex seek_mu_;
+        std::vector<SeekTarget> pending_seeks_;
+        std::atomic<bool> seek_pending_{false};
+        std::atomic<std::uint32_t> seek_gen_{0};
+        std::vector<std::vector<std::uint32_t>> seek_floor_;
+        std::vector<std::vector<std::uint32_t>> drain_seek_floor_;   // drain thread copy
+        std::uint32_t drain_seek_gen_{0};
+        rd_kafka_topic_partition_list_t* catchup_{nullptr};          // consumer thread only
+
         std::atomic<std::size_t> rr_{0};
         std::atomic<std::size_t> drain_rr_{0};
 
@@ -161,6 +676,7 @@ namespace kafkax {
         rd_kafka_topic_partition_list_t* assignment_{nullptr};
 
         DecoderRegistry registry_;
+        TopicTable topics_;
 
         int efd_{-1};                                 // eventfd for sd1 wakeup
         std::atomic<bool> evt_notified_{false};     // coalesce notify (armed flag)
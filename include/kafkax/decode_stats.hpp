@@ -0,0 +1,96 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace kafkax {
+
+    /* Decoder cost for one (topic, binding). A binding id names one bind/rebind
+     * (DecoderRegistry::binding_info), so old and new plugins stay separate. */
+    struct DecoderCost {
+        std::uint32_t topic_id{0};
+        std::uint32_t binding{0};
+        std::uint64_t calls{0};       // messages decoded (batch calls count each message)
+        std::uint64_t total_ns{0};
+        std::uint64_t max_ns{0};      // slowest message (batch: slowest per-message average)
+        std::uint64_t bytes_in{0};
+        std::uint64_t bytes_out{0};
+        std::uint64_t retries{0};     // KAFKAX_DECODE_NEED_MORE round trips
+        std::uint64_t errors{0};
+    };
+
+    /* One per decode worker. Counters have a single writer (relaxed load/store);
+     * the writer only locks when it first meets a (topic, binding). */
+    class DecodeCostRecorder {
+    public:
+        struct Slot {
+            std::uint32_t topic_id{0};
+            std::uint32_t binding{0};
+            std::atomic<std::uint64_t> calls{0};
+            std::atomic<std::uint64_t> total_ns{0};
+            std::atomic<std::uint64_t> max_ns{0};
+            std::atomic<std::uint64_t> bytes_in{0};
+            std::atomic<std::uint64_t> bytes_out{0};
+            std::atomic<std::uint64_t> retries{0};
+            std::atomic<std::uint64_t> errors{0};
+
+            void add(std::uint64_t n, std::uint64_t ns, std::uint64_t in, std::uint64_t out,
+                     std::uint64_t retried, std::uint64_t failed) noexcept {
+                bump(calls, n);
+                bump(total_ns, ns);
+                bump(bytes_in, in);
+                bump(bytes_out, out);
+                bump(retries, retried);
+                bump(errors, failed);
+                const auto per = n ? ns / n : ns;
+                if (per > max_ns.load(std::memory_order_relaxed))
+                    max_ns.store(per, std::memory_order_relaxed);
+            }
+
+        private:
+            static void bump(std::atomic<std::uint64_t>& c, std::uint64_t v) noexcept {
+                if (v) c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+            }
+        };
+
+        /* owning thread only; the pointer stays valid for the recorder's lifetime */
+        Slot* slot(std::uint32_t topic_id, std::uint32_t binding) {
+            std::lock_guard<std::mutex> lk(mu_);
+            for (auto& s : slots_)
+                if (s.topic_id == topic_id && s.binding == binding) return &s;
+            auto& s = slots_.emplace_back();
+            s.topic_id = topic_id;
+            s.binding = binding;
+            return &s;
+        }
+
+        /* any thread: add this recorder's counters into out (merged by key) */
+        void merge_into(std::vector<DecoderCost>& out) const {
+            std::lock_guard<std::mutex> lk(mu_);
+            for (const auto& s : slots_) {
+                auto it = std::find_if(out.begin(), out.end(), [&](const DecoderCost& c) {
+                    return c.topic_id == s.topic_id && c.binding == s.binding;
+                });
+                if (it == out.end()) {
+                    out.push_back(DecoderCost{s.topic_id, s.binding});
+                    it = out.end() - 1;
+                }
+                it->calls += s.calls.load(std::memory_order_relaxed);
+                it->total_ns += s.total_ns.load(std::memory_order_relaxed);
+                it->max_ns = std::max(it->max_ns, s.max_ns.load(std::memory_order_relaxed));
+                it->bytes_in += s.bytes_in.load(std::memory_order_relaxed);
+                it->bytes_out += s.bytes_out.load(std::memory_order_relaxed);
+                it->retries += s.retries.load(std::memory_order_relaxed);
+                it->errors += s.errors.load(std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        mutable std::mutex mu_;
+        std::deque<Slot> slots_;   // deque: emplace_back keeps Slot* stable
+    };
+
+} // namespace kafkax
@@ -1,4 +1,4 @@
-// include/kafkax/decoder.h  (v2-only)
+// include/kafkax/decoder.h  (v3; v2 plugins are still accepted)
 #pragma once
 #include <stddef.h>
 #include <stdint.h>
@@ -7,7 +7,9 @@
 extern "C" {
 #endif
 
-#define KAFKAX_DECODER_ABI_VERSION 2
+#define KAFKAX_DECODER_ABI_VERSION 3
+/* Oldest plugin ABI the host still loads. v2 plugins have no batch entrypoint. */
+#define KAFKAX_DECODER_ABI_VERSION_MIN 2
 
 /* ----------- Common result kinds ----------- */
 typedef enum kafkax_decode_kind_t {
@@ -78,6 +80,56 @@ typedef int (*kafkax_decode_fn)(
     kafkax_decode_out_t* out
 );
 
+/* ----------- Batch decode (v3, optional) ----------- */
+/* For a bound symbol <name>, the host looks up <name>_batch with dlsym.
+ * When present it is preferred over <name> for runs of messages from the same topic;
+ * <name> must still be exported and is used as the fallback.
+ *
+ * OK results are not copied: each event points at its slice of the arena
+ * until it is recycled, so only arena[0, used) may hold results. The arena
+ * is the free tail of a larger host block; later calls may get the bytes
+ * after used. */
+
+typedef struct kafkax_decode_result_t {
+    kafkax_decode_kind_t kind;
+
+    /* OK: output is arena[offset, offset + len) */
+    size_t offset;
+    size_t len;
+
+    /* NEED_MORE: arena bytes this message needs */
+    size_t need;
+
+    /* ERR (optional): static string, must outlive the call; NULL -> generic message */
+    const char* err;
+} kafkax_decode_result_t;
+
+typedef struct kafkax_decode_batch_out_t {
+    /* caller-provided contiguous output arena */
+    uint8_t* arena;
+    size_t cap;
+
+    /* decoder advances used as it appends outputs */
+    size_t used;
+
+    /* caller-provided, one slot per envelope */
+    kafkax_decode_result_t* results;
+
+    /* decoder sets count = number of results filled, in envelope order.
+     * If the arena runs out, the decoder fills results[count - 1] with NEED_MORE
+     * and stops; the host re-calls from that envelope with a larger arena. */
+    size_t count;
+
+    /* decoder sets err_msg when it returns non-zero (whole batch failed) */
+    char err_msg[256];
+} kafkax_decode_batch_out_t;
+
+typedef int (*kafkax_decode_batch_fn)(
+    const kafkax_envelope_t* envs,
+    size_t n,
+    kafkax_decode_batch_out_t* out
+);
+
 /* ----------- Built-in decoders ----------- */
 int kafkax_passthrough_decoder(const kafkax_envelope_t* env,
                                kafkax_decode_out_t* out);
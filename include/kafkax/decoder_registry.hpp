@@ -1,4 +1,6 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -9,12 +11,23 @@
 
 namespace kafkax {
 
+    struct Route {
+        kafkax_decode_fn fn{nullptr};
+        kafkax_decode_batch_fn batch_fn{nullptr};   // optional (ABI v3)
+        std::uint32_t binding{0};                   // BindingInfo::id; 0 = unbound
+    };
+
     struct Router {
-        std::unordered_map<std::string, kafkax_decode_fn> table;
+        std::unordered_map<std::string, Route> table;
 
         kafkax_decode_fn lookup(const std::string& topic) const {
             auto it = table.find(topic);
-            return it == table.end() ? nullptr : it->second;
+            return it == table.end() ? nullptr : it->second.fn;
+        }
+
+        Route lookup_route(const std::string& topic) const {
+            auto it = table.find(topic);
+            return it == table.end() ? Route{} : it->second;
         }
     };
 
@@ -23,6 +36,7 @@ namespace kafkax {
         struct BindingInfo {
             std::string so_path;
             std::string symbol;
+            std::uint32_t id{0};   // unique per bind/rebind, never reused
         };
 
         DecoderRegistry();
@@ -49,7 +63,22 @@ namespace kafkax {
 
         kafkax_decode_fn get_fn(const std::string& topic) const;
 
+        /* Current immutable router. Hot paths cache it and re-fetch only when
+         * generation() moves (read generation first, then snapshot). */
+        std::shared_ptr<const Router> snapshot() const {
+            return router_.load(std::memory_order_acquire);
+        }
+
         bool get_decoder_info(const std::string& topic, BindingInfo& out) const;
+
+        /* Any binding ever made, including replaced ones (Route::binding). */
+        bool binding_info(std::uint32_t id, BindingInfo& out) const;
+
+        /* Bumped on every bind/rebind/unbind; lets readers cache binding-derived data. */
+        std::uint64_t generation() const noexcept {
+            return generation_.load(std::memory_order_acquire);
+        }
+
         /* Combined mode: preload bindings from a simple config file.
          * Format: <topic><space><symbol_or_alias>
          * - symbol_or_alias may be a real exported function name (e.g. decode_basicqot)
@@ -64,6 +93,7 @@ namespace kafkax {
         struct PluginHandle {
             void* handle;
             std::string so_path;
+            int abi_version{KAFKAX_DECODER_ABI_VERSION};
         };
 
         struct BindingEntry {
@@ -80,13 +110,18 @@ namespace kafkax {
                            kafkax_decode_fn& fn,
                            std::string& err) const;
 
+        kafkax_decode_batch_fn resolve_batch_symbol(std::size_t plugin_idx,
+                                                    const std::string& symbol) const;
+
     private:
         std::atomic<std::shared_ptr<const Router>> router_;
+        std::atomic<std::uint64_t> generation_{0};
         mutable std::mutex mu_;
 
         std::vector<PluginHandle> loaded_plugins_;
         std::unordered_map<std::string, std::size_t> so_to_plugin_;
         std::unordered_map<std::string, BindingEntry> topic_bindings_;
+        std::vector<BindingInfo> binding_log_;   // [id - 1]
     };
 
 } // namespace kafkax
\ No newline at end of file
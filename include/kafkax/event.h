@@ -1,27 +1,113 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+struct rd_kafka_message_s;
+
 namespace kafkax {
 
+    /* Deleter for a held rdkafka message (defined in core.cpp). */
+    struct MsgRelease {
+        void operator()(rd_kafka_message_s* msg) const noexcept;
+    };
+
+    /* std::allocator whose value-initialising construct() is a no-op, so
+     * resize() on a byte buffer leaves the new bytes as they are. */
+    template <class T>
+    struct UninitAllocator : std::allocator<T> {
+        template <class Other> struct rebind { using other = UninitAllocator<Other>; };
+
+        UninitAllocator() noexcept = default;
+        template <class Other> UninitAllocator(const UninitAllocator<Other>&) noexcept {}
+
+        template <class Other>
+        void construct(Other* p) noexcept(std::is_nothrow_default_constructible_v<Other>) {
+            ::new (static_cast<void*>(p)) Other;
+        }
+        template <class Other, class... Args>
+        void construct(Other* p, Args&&... args) {
+            ::new (static_cast<void*>(p)) Other(std::forward<Args>(args)...);
+        }
+    };
+
+    /* Decode output buffer: a recycled Event is decoded into its whole retained
+     * capacity, which must not cost a memset of that capacity on every reuse. */
+    using ByteBuffer = std::vector<std::uint8_t, UninitAllocator<std::uint8_t>>;
+
+    /* A batch decode arena (decoder.h, <name>_batch): the events decoded into
+     * it borrow their slices and hold one reference each; the decode worker
+     * that owns it reuses it once refs drops back to 0. */
+    struct ArenaBlock {
+        std::atomic<std::uint32_t> refs{0};
+        ByteBuffer bytes;
+    };
+
+    struct ArenaRelease {
+        void operator()(ArenaBlock* block) const noexcept {
+            block->refs.fetch_sub(1, std::memory_order_release);
+        }
+    };
+
     struct Event {
         enum class Kind : std::uint8_t { Data = 0, Error = 1 };
 
         Kind kind{Kind::Data};
 
-        std::string topic;
+        /* Decode worker that produced this event; Core::recycle() returns it there. */
+        std::uint32_t worker{0};
+
+        /* Interned topic id (Core::topic_name() maps it back). */
+        std::uint32_t topic_id{0xFFFFFFFFu};
+        std::int32_t partition{-1};
+        std::int64_t offset{-1};
+        std::uint32_t seek_gen{0};   // seek generation at dispatch; older ones are flushed by drainTo
         std::vector<std::uint8_t> key;
         std::int64_t ingest_ns{0};
 
+        /* Local monotonic stamps (DecodeConfig::latency_stats), 0 otherwise. */
+        std::int64_t poll_ns{0};
+        std::int64_t ready_ns{0};   // decode finished
+
         /* Observability: which decoder produced this. */
         std::string decoder;
 
         /* Success payload (decoded bytes, e.g. q kbytes later) */
-        std::vector<std::uint8_t> bytes;
+        ByteBuffer bytes;
 
         /* Error message (fixed size to keep ABI-friendly patterns) */
         char err_msg[96]{0};
+
+        /* Zero-copy mode: the source message is held here and payload()/key_view()
+         * point into it instead of bytes/key. Released by Core::recycle() or on destruction. */
+        std::unique_ptr<rd_kafka_message_s, MsgRelease> msg;
+        std::span<const std::uint8_t> payload_ref;
+        std::span<const std::uint8_t> key_ref;
+
+        /* Batch decode: payload() is payload_ref, a slice of this arena.
+         * Released with msg. */
+        std::unique_ptr<ArenaBlock, ArenaRelease> arena;
+
+        std::span<const std::uint8_t> payload() const noexcept {
+            return msg || arena ? payload_ref : std::span<const std::uint8_t>(bytes);
+        }
+
+        std::span<const std::uint8_t> key_view() const noexcept {
+            return msg ? key_ref : std::span<const std::uint8_t>(key);
+        }
+
+        void release_msg() noexcept {
+            msg.reset();
+            arena.reset();
+            payload_ref = {};
+            key_ref = {};
+        }
     };
 
 } // namespace kafkax
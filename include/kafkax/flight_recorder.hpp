@@ -0,0 +1,109 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kafkax {
+
+    /* One recorded message, as handed to readers. */
+    struct FlightRecord {
+        static constexpr std::size_t kPrefix = 64;   // payload bytes kept
+        static constexpr std::size_t kErr = 56;      // err_msg chars kept
+
+        enum Status : std::uint8_t { Ok = 0, Error = 1 };
+
+        std::int64_t ts_ns{0};           // wall clock, end of the decode batch
+        std::uint32_t topic_id{0};
+        std::int32_t partition{-1};
+        std::int64_t offset{-1};
+        std::uint32_t decode_ns{0};      // this message's share of its batch's decode time
+        std::uint32_t payload_len{0};    // full length; prefix holds the first prefix_len bytes
+        std::uint8_t worker{0};
+        std::uint8_t status{Ok};
+        std::uint8_t prefix_len{0};
+        std::uint8_t err_len{0};
+        std::uint8_t prefix[kPrefix];
+        char err[kErr];
+    };
+
+    /* The last capacity() messages one decode worker handled, as a ring of
+     * fixed-size slots allocated up front. Single writer (the worker), any
+     * number of readers; each slot is a seqlock, so the writer never waits and
+     * a reader just drops a slot it saw being overwritten. */
+    class FlightRecorder {
+    public:
+        /* capacity is rounded up to a power of two */
+        FlightRecorder(std::size_t capacity, std::uint8_t worker);
+
+        std::size_t capacity() const noexcept { return mask_ + 1; }
+
+        /* writer: open the next slot and fill its input side; the slot is
+         * invisible to readers until finish(). */
+        std::size_t begin(std::uint32_t topic_id, std::int32_t partition, std::int64_t offset,
+                          const void* payload, std::size_t len) noexcept {
+            const auto pos = head_.load(std::memory_order_relaxed);
+            auto& s = slots_[pos & mask_];
+            const auto seq = s.seq.load(std::memory_order_relaxed);
+            s.seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            auto& r = s.rec;
+            r.topic_id = topic_id;
+            r.partition = partition;
+            r.offset = offset;
+            r.payload_len = static_cast<std::uint32_t>(len);
+            r.prefix_len = static_cast<std::uint8_t>(len < FlightRecord::kPrefix ? len : FlightRecord::kPrefix);
+            if (payload && r.prefix_len) std::memcpy(r.prefix, payload, r.prefix_len);
+            else r.prefix_len = 0;
+
+            head_.store(pos + 1, std::memory_order_relaxed);
+            return pos;
+        }
+
+        /* writer: outcome of the message begin() returned pos for */
+        void finish(std::size_t pos, std::int64_t ts_ns, std::uint32_t decode_ns,
+                    bool ok, const char* err) noexcept {
+            auto& s = slots_[pos & mask_];
+            auto& r = s.rec;
+            r.ts_ns = ts_ns;
+            r.decode_ns = decode_ns;
+            r.status = ok ? FlightRecord::Ok : FlightRecord::Error;
+            r.err_len = 0;
+            if (!ok && err) {
+                const auto n = ::strnlen(err, FlightRecord::kErr);
+                std::memcpy(r.err, err, n);
+                r.err_len = static_cast<std::uint8_t>(n);
+            }
+            s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        static constexpr std::uint32_t kAllTopics = 0xFFFFFFFFu;   // == TopicTable::kInvalid
+
+        /* any thread: append finished records for topic_id (or kAllTopics), oldest first */
+        void snapshot(std::uint32_t topic_id, std::vector<FlightRecord>& out) const;
+
+    private:
+        struct alignas(64) Slot {
+            std::atomic<std::uint32_t> seq{0};   // odd while being written
+            FlightRecord rec;
+        };
+
+        std::unique_ptr<Slot[]> slots_;
+        std::size_t mask_;
+        std::atomic<std::size_t> head_{0};
+        std::uint8_t worker_;
+    };
+
+    /* One tab-separated line per record:
+     *   ts_ns worker topic partition offset status decode_ns payload_len prefix_hex err
+     * topic_names is indexed by FlightRecord::topic_id. Temp file + rename. */
+    bool write_flight_records(const std::vector<FlightRecord>& recs,
+                              const std::vector<std::string>& topic_names,
+                              const std::string& path,
+                              std::string& err);
+
+} // namespace kafkax
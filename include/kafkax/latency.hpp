@@ -0,0 +1,100 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace kafkax {
+
+    /* Where a message spends its time, in pipeline order. All but Broker are
+     * monotonic deltas; Broker compares the broker timestamp with wall-clock
+     * poll time, so it includes producer/broker clock skew.
+     *   Broker   broker timestamp -> poll
+     *   Queue    poll -> decode start (raw ring)
+     *   Decode   decoder time (per-batch time / batch size)
+     *   Publish  decode end -> event ring push (blocked on a full ring)
+     *   Drain    decode end -> drainTo
+     *   Total    poll -> drainTo */
+    enum class LatencyStage : std::uint8_t {
+        Broker = 0,
+        Queue,
+        Decode,
+        Publish,
+        Drain,
+        Total,
+        Count
+    };
+
+    const char* latency_stage_name(LatencyStage s) noexcept;
+
+    /* Log-linear histogram: 16 linear sub-buckets per power of two (~3% error),
+     * values clamped to 2^40 ns. One writer, any number of readers; counts are
+     * plain relaxed load/store on the writer side. */
+    class LatencyHistogram {
+    public:
+        static constexpr int kSubBits = 4;
+        static constexpr int kMaxExp = 40;
+        static constexpr std::size_t kSub = std::size_t{1} << kSubBits;
+        static constexpr std::size_t kBuckets = kSub + (kMaxExp - kSubBits + 1) * kSub;
+
+        void record(std::int64_t ns, std::uint64_t count = 1) noexcept {
+            auto& c = counts_[bucket_of(ns)];
+            c.store(c.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        }
+
+        /* acc must hold kBuckets entries */
+        void add_to(std::uint64_t* acc) const noexcept;
+
+        static std::size_t bucket_of(std::int64_t ns) noexcept;
+        static std::int64_t bucket_value(std::size_t b) noexcept;   // bucket midpoint
+
+    private:
+        std::array<std::atomic<std::uint64_t>, kBuckets> counts_{};
+    };
+
+    /* Merged counts (kBuckets entries, see add_to) -> p50, p90, p99, p999 and
+     * max as bucket midpoints in out; all 0 when empty. Returns the sample count. */
+    std::uint64_t percentiles(const std::uint64_t* acc, std::int64_t out[5]) noexcept;
+
+    /* One per recording thread: per topic id, one histogram per stage.
+     * The owning thread only takes mu_ the first time it sees a topic. */
+    class LatencyRecorder {
+    public:
+        using Stages = std::array<LatencyHistogram, static_cast<std::size_t>(LatencyStage::Count)>;
+
+        /* owning thread only */
+        Stages& topic(std::uint32_t topic_id) {
+            if (topic_id < topics_.size() && topics_[topic_id]) return *topics_[topic_id];
+            return grow(topic_id);
+        }
+
+        /* any thread: f(topic_id, const Stages&) */
+        template <class F>
+        void for_each(F&& f) const {
+            std::lock_guard<std::mutex> lk(mu_);
+            for (std::size_t i = 0; i < topics_.size(); ++i)
+                if (topics_[i]) f(static_cast<std::uint32_t>(i), *topics_[i]);
+        }
+
+    private:
+        Stages& grow(std::uint32_t topic_id);
+
+        mutable std::mutex mu_;
+        std::vector<std::unique_ptr<Stages>> topics_;
+    };
+
+    struct LatencyRow {
+        std::uint32_t topic_id{0};
+        LatencyStage stage{LatencyStage::Total};
+        std::uint64_t count{0};
+        std::int64_t p50{0}, p90{0}, p99{0}, p999{0}, max{0};   // ns
+    };
+
+    /* Merge every recorder and append one row per (topic, stage) with samples. */
+    void merge_latency(const std::vector<const LatencyRecorder*>& recs,
+                       std::vector<LatencyRow>& out);
+
+} // namespace kafkax
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <librdkafka/rdkafka.h>
+
+namespace kafkax {
+
+    /* Where Core's consumer thread gets messages from. The Kafka consumer is
+     * one source; the others feed the same dispatch/decode/drain path without
+     * a broker (benchmarks, backtests over recorded feeds).
+     *
+     * Messages are rd_kafka_message_t either way, so the decode path is the
+     * production one. Non-Kafka sources build them with SourceMessagePool;
+     * release_message(), message_topic() and message_timestamp() work on both
+     * kinds and are what Core uses instead of the librdkafka calls. */
+    class MessageSource {
+    public:
+        virtual ~MessageSource() = default;
+
+        /* Core::subscribe, before the consumer thread starts: what to deliver. */
+        virtual int subscribe(const std::vector<std::string>& topics, std::string& err) = 0;
+
+        /* Consumer thread: fill out with up to out.size() messages, waiting at
+         * most timeout_ms for the first; returns how many. The caller owns them. */
+        virtual std::size_t poll(std::span<rd_kafka_message_t*> out, int timeout_ms) = 0;
+
+        /* Nothing more will come (end of a capture, synthetic count reached). */
+        virtual bool done() const noexcept { return false; }
+
+        /* The broker-backed source: seeks, pause/resume and commits apply. */
+        virtual bool is_kafka() const noexcept { return false; }
+    };
+
+    struct SourceConfig {
+        enum class Kind : std::uint8_t { Kafka = 0, Synthetic = 1, Replay = 2 };
+        Kind kind{Kind::Kafka};
+
+        /* Synthetic: round-robin over the subscribed topics and partitions
+         * partitions each, payload_size random bytes and a key_size-byte key.
+         * count 0 = unbounded; rate in msgs/s, 0 = as fast as the rings take them. */
+        std::uint64_t count{0};
+        std::uint64_t rate{0};
+        std::size_t payload_size{256};
+        std::size_t key_size{0};
+        std::int32_t partitions{1};
+        std::uint64_t seed{1};
+
+        /* Replay: the subscribed topics' messages of a capture file
+         * (kafkax/capture.hpp), in file order. speed 0 = as fast as possible,
+         * 1 = recorded pace (timestamp gaps), N = N times faster. */
+        std::string path{};
+        double speed{0.0};
+    };
+
+    /* Synthetic or Replay source; Kafka is built by Core::subscribe itself.
+     * nullptr (err) on a bad config or an unreadable capture. */
+    std::unique_ptr<MessageSource> make_source(const SourceConfig& cfg, std::string& err);
+
+    /* Wraps a subscribed consumer handle; rk stays owned by the caller and
+     * must outlive the source. */
+    std::unique_ptr<MessageSource> make_kafka_source(rd_kafka_t* rk);
+
+    /* Recycled message shells owned by no librdkafka handle. make() belongs to
+     * one thread (the source's poll); release_message() hands a shell back from
+     * any thread onto a lock-free stack, which make() takes over whole once its
+     * own list runs dry. Every message must be released before the pool goes. */
+    class SourceMessagePool {
+    public:
+        SourceMessagePool() = default;
+        ~SourceMessagePool();
+
+        SourceMessagePool(const SourceMessagePool&) = delete;
+        SourceMessagePool& operator=(const SourceMessagePool&) = delete;
+
+        /* topic must outlive the message and be the same object for every
+         * message of that topic (it stands in for rkt); key and payload are
+         * views that must outlive it too. */
+        rd_kafka_message_t* make(const std::string* topic,
+                                 std::int32_t partition,
+                                 std::int64_t offset,
+                                 std::int64_t timestamp_ms,
+                                 const void* key, std::size_t key_len,
+                                 const void* payload, std::size_t len);
+
+        struct Shell;
+
+    private:
+        friend void release_message(rd_kafka_message_t* msg) noexcept;
+        void give_back(Shell* s) noexcept;
+
+        Shell* local_{nullptr};                              // make() only
+        alignas(64) std::atomic<Shell*> returned_{nullptr};  // released, any thread
+    };
+
+    bool is_source_message(const rd_kafka_message_t* msg) noexcept;
+
+    /* rd_kafka_message_destroy, or back to its pool for a source message. */
+    void release_message(rd_kafka_message_t* msg) noexcept;
+
+    /* rd_kafka_topic_name(msg->rkt) */
+    const char* message_topic(const rd_kafka_message_t* msg) noexcept;
+
+    /* rd_kafka_message_timestamp; -1 if none */
+    std::int64_t message_timestamp(const rd_kafka_message_t* msg) noexcept;
+
+} // namespace kafkax
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kafkax {
+
+    /* The parts of librdkafka's statistics JSON (stats_cb) we tune against.
+     * Times are microseconds as librdkafka reports them; -1 = not reported. */
+    struct KafkaStats {
+        std::int64_t ts_us{0};
+
+        struct Broker {
+            std::string name;
+            std::int32_t nodeid{-1};
+            std::string state;
+            std::int64_t rtt_avg_us{-1};
+            std::int64_t rtt_p99_us{-1};
+            std::int64_t outbuf_cnt{0};
+        };
+
+        struct Partition {
+            std::string topic;
+            std::int32_t partition{0};
+            std::int64_t consumer_lag{-1};
+            std::int64_t fetchq_cnt{0};
+            std::int64_t fetchq_size{0};     // bytes
+            std::int64_t hi_offset{-1};
+            std::int64_t committed_offset{-1};
+        };
+
+        std::vector<Broker> brokers;
+        std::vector<Partition> partitions;   // assigned/known partitions only (no -1 UA)
+    };
+
+    /* Returns false (err set) on malformed JSON; unknown fields are ignored. */
+    bool parse_kafka_stats(std::string_view json, KafkaStats& out, std::string& err);
+
+    /* Core's own counters plus the latest KafkaStats. */
+    struct Metrics {
+        std::uint64_t consumed{0};          // messages handed to decode
+        std::uint64_t drained{0};           // events returned by drainTo
+        std::uint64_t decode_errors{0};     // Error events produced by decode
+        std::uint64_t kafka_errors{0};      // error_cb calls + consumed messages with err set
+        std::uint64_t pauses{0};            // global backpressure pauses
+        std::uint64_t partition_pauses{0};  // per-partition pauses
+        std::uint64_t steals{0};
+        std::uint64_t seek_errors{0};       // partitions a seek failed to move
+        std::uint64_t raw_depth{0};
+        std::uint64_t evt_depth{0};
+        bool paused{false};
+        std::string last_error;
+
+        bool has_kafka_stats{false};
+        KafkaStats kafka;
+    };
+
+    /* One flat sample; label is the topic or broker name (may be empty),
+     * partition is -1 when not per-partition. */
+    struct MetricSample {
+        const char* name;
+        const char* help;
+        bool counter;
+        std::string label_key;
+        std::string label;
+        std::int32_t partition{-1};
+        double value{0};
+    };
+
+    void flatten_metrics(const Metrics& m, std::vector<MetricSample>& out);
+
+    /* Prometheus text exposition (version 0.0.4) of flatten_metrics(m). */
+    std::string render_prometheus(const Metrics& m);
+
+    /* Write render_prometheus(m) to path via a temp file + rename, so a
+     * scraper (node_exporter textfile collector) never sees a partial file. */
+    bool write_prometheus_file(const Metrics& m, const std::string& path, std::string& err);
+
+} // namespace kafkax
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace kafkax::placement {
+
+    /* Where a block of ring memory should live. node < 0 leaves it to the
+     * kernel (first touch); huge asks for 2MB pages, falling back to THP. */
+    struct MemPolicy {
+        int node{-1};
+        bool huge{false};
+
+        bool is_default() const noexcept { return node < 0 && !huge; }
+    };
+
+    /* taskset syntax: "0-3,8,10-11". Empty string -> empty list.
+     * Returns false (and leaves cpus untouched) on a malformed list or a CPU
+     * number of CPU_SETSIZE or more. */
+    bool parse_cpu_list(const std::string& spec, std::vector<int>& cpus);
+
+    /* Pin the calling thread; no-op for an empty list. 0 or errno. */
+    int pin_current_thread(const std::vector<int>& cpus);
+
+    /* Thread name as shown by top -H / /proc/<pid>/task/<tid>/comm;
+     * truncated to 15 characters. */
+    void name_current_thread(const std::string& name);
+
+    /* NUMA node of cpu from sysfs; -1 when unknown (no NUMA, container, ...). */
+    int cpu_node(int cpu);
+
+    /* Anonymous mapping placed per policy; nullptr on failure.
+     * Release with free_pages() using the same byte count and policy. */
+    void* alloc_pages(std::size_t bytes, const MemPolicy& policy);
+    void free_pages(void* p, std::size_t bytes, const MemPolicy& policy) noexcept;
+
+} // namespace kafkax::placement
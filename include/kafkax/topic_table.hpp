@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace kafkax {
+
+    /* Dense topic ids. Ids are assigned once and never reused, and the
+     * string returned by name() stays valid for the table's lifetime, so
+     * hot paths can keep the id (and a pointer to the name) instead of a copy. */
+    class TopicTable {
+    public:
+        static constexpr std::uint32_t kInvalid = 0xFFFFFFFFu;
+
+        /* Returns the id for name, assigning the next one on first use. */
+        std::uint32_t intern(std::string_view name);
+
+        /* kInvalid if name was never interned. */
+        std::uint32_t find(std::string_view name) const;
+
+        /* Empty string for unknown ids. */
+        const std::string& name(std::uint32_t id) const;
+
+        std::size_t size() const;
+
+    private:
+        mutable std::mutex mu_;
+        std::unordered_map<std::string, std::uint32_t> ids_;
+        std::deque<std::string> names_;   // deque: push_back keeps references stable
+    };
+
+} // namespace kafkax
@@ -0,0 +1,30 @@
+#pragma once
+
+/* Static tracepoints (USDT, provider "kafkax"). Compiled in with
+ * -DKAFKAX_USDT=ON, which needs <sys/sdt.h> (systemtap-sdt-dev); each probe
+ * is then a single nop until perf/bpftrace attaches. Without it they vanish
+ * and their arguments are not evaluated.
+ *
+ *   poll            (n)                          consumer: messages from one poll
+ *   push_blocked    (worker, pending)            consumer: raw ring full, about to wait
+ *   pause           (raw_depth, evt_depth)       consumer: assignment paused
+ *   resume          (paused_partitions)          consumer: assignment resumed
+ *   partition_pause (topic, partition, depth)
+ *   partition_resume(topic, partition, depth)
+ *   decode_start    (topic, partition, offset)   single-message decoder call
+ *   decode_end      (topic, partition, offset, ok)
+ *   batch_start     (topic, n)                   batch decoder call (ABI v3)
+ *   batch_end       (topic, n, decoded)
+ *   need_more       (topic, offset, need)        decoder asked for a larger buffer
+ *   decode_error    (topic, partition, offset, err_msg)
+ *   evt_blocked     (worker, pending)            decode: event ring full, about to wait
+ *   drain           (n, left_nonempty)           drainTo returned
+ *
+ * e.g. bpftrace -e 'usdt:./libkafkax_q.so:kafkax:drain { @ = hist(arg0); }'
+ */
+#if defined(KAFKAX_WITH_USDT)
+#include <sys/sdt.h>
+#define KAFKAX_PROBE(name, ...) STAP_PROBEV(kafkax, name, __VA_ARGS__)
+#else
+#define KAFKAX_PROBE(name, ...) ((void)0)
+#endif
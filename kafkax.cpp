@@ -1,5 +1,6 @@
 #include "kx/k.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cerrno>
 #include <cstdint>
@@ -21,6 +22,14 @@ namespace {
         std::unique_ptr<kafkax::Core> core;
         int efd{-1};
         bool sd1_registered{false};
+
+        /* drain-side symbols per topic id (q main thread only) */
+        std::vector<S> topic_syms;
+        std::vector<S> tbl_syms;              // reset when binding generation changes
+        std::uint64_t tbl_gen{0};
+
+        /* drainTo target (q main thread only); recycle() empties it, capacity stays */
+        std::vector<kafkax::Event> drained;
     };
 
     std::mutex g_mu;
@@ -74,13 +83,46 @@ namespace {
         }
     }
 
+    // topic / tbl symbols for a topic id, interned once per id (tbl once per binding generation)
+    static inline void topic_syms_for(Entry& e, std::uint32_t id, S& topic, S& tbl) {
+        if (id == kafkax::TopicTable::kInvalid) {
+            topic = tbl = ss((S)"");
+            return;
+        }
+
+        if (id >= e.topic_syms.size()) {
+            e.topic_syms.resize((std::size_t)id + 1, nullptr);
+            e.tbl_syms.resize((std::size_t)id + 1, nullptr);
+        }
+
+        if (!e.topic_syms[id]) {
+            e.topic_syms[id] = ss((S)e.core->topic_name(id).c_str());
+        }
+        if (!e.tbl_syms[id]) {
+            kafkax::DecoderRegistry::BindingInfo bi{};
+            if (e.core->get_topic_decoder(e.core->topic_name(id), bi)) {
+                e.tbl_syms[id] = ss((S)bi.symbol.c_str());
+            } else {
+                e.tbl_syms[id] = e.topic_syms[id];
+            }
+        }
+
+        topic = e.topic_syms[id];
+        tbl = e.tbl_syms[id];
+    }
+
     static inline K k_errvec(const char* s, std::size_t cap) {
         if (!s || cap == 0) return ktn(KC, 0);
         std::size_t n = ::strnlen(s, cap);
         return kpn((S)s, (J)n);  // q char vector length n
     }
 
-    static void parse_cfg(K cfg, kafkax::Core::DecodeConfig& dcfg, kafkax::Core::KafkaConfig& kcfg)
+    // false (err) on a bad value for an enum-valued key
+    static bool parse_cfg(K cfg,
+                          kafkax::Core::DecodeConfig& dcfg,
+                          kafkax::Core::KafkaConfig& kcfg,
+                          kafkax::SourceConfig& scfg,
+                          std::string& err)
     {
         dcfg.decode_threads = 4;
         dcfg.raw_queue_size = 8192;
@@ -89,7 +131,7 @@ namespace {
         kcfg.enable_auto_commit = true;
         kcfg.auto_offset_reset = "earliest";
 
-        if (!k_is_dict(cfg)) return;
+        if (!k_is_dict(cfg)) return true;
 
         K v = nullptr;
 
@@ -107,6 +149,73 @@ namespace {
             else if (v->t == -KJ) dcfg.evt_queue_size = (std::size_t)std::max<J>(1, v->j);
         }
 
+        if (dict_get(cfg, "route_policy", v) && v) {
+            auto p = k_to_string(v);
+            if (p == "roundrobin" || p == "rr") dcfg.route_policy = kafkax::Core::RoutePolicy::RoundRobin;
+            else if (p == "partition") dcfg.route_policy = kafkax::Core::RoutePolicy::PartitionAffinity;
+            else if (p == "key") dcfg.route_policy = kafkax::Core::RoutePolicy::KeyHash;
+            else if (p == "leastloaded") dcfg.route_policy = kafkax::Core::RoutePolicy::LeastLoaded;
+            else {
+                err = "route_policy: expected roundrobin, partition, key or leastloaded, got '" + p + "'";
+                return false;
+            }
+        }
+
+        if (dict_get(cfg, "consume_batch", v) && v) {
+            if (v->t == -KI) dcfg.consume_batch = (std::size_t)std::max(0, v->i);
+            else if (v->t == -KJ) dcfg.consume_batch = (std::size_t)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "catchup_batch", v) && v) {
+            if (v->t == -KI) dcfg.catchup_batch = (std::size_t)std::max(0, v->i);
+            else if (v->t == -KJ) dcfg.catchup_batch = (std::size_t)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "consume_timeout_ms", v) && v) {
+            if (v->t == -KI) dcfg.consume_timeout_ms = std::max(0, v->i);
+            else if (v->t == -KJ) dcfg.consume_timeout_ms = (int)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "work_stealing", v) && v) {
+            if (v->t == -KB) dcfg.work_stealing = (bool)v->g;
+            else if (v->t == -KI) dcfg.work_stealing = (v->i != 0);
+            else if (v->t == -KJ) dcfg.work_stealing = (v->j != 0);
+            else dcfg.work_stealing = (k_to_string(v) == "true");
+        }
+        if (dict_get(cfg, "steal_threshold", v) && v) {
+            if (v->t == -KI) dcfg.steal_threshold = (std::size_t)std::max(1, v->i);
+            else if (v->t == -KJ) dcfg.steal_threshold = (std::size_t)std::max<J>(1, v->j);
+        }
+        if (dict_get(cfg, "wait_strategy", v) && v) {
+            auto w = k_to_string(v);
+            if (w == "blocking") dcfg.wait_strategy = kafkax::Core::WaitStrategy::Blocking;
+            else if (w == "spin") dcfg.wait_strategy = kafkax::Core::WaitStrategy::SpinThenPark;
+            else if (w == "busypoll") dcfg.wait_strategy = kafkax::Core::WaitStrategy::BusyPoll;
+            else {
+                err = "wait_strategy: expected blocking, spin or busypoll, got '" + w + "'";
+                return false;
+            }
+        }
+        if (dict_get(cfg, "spin_iterations", v) && v) {
+            if (v->t == -KI) dcfg.spin_iterations = (std::uint32_t)std::max(0, v->i);
+            else if (v->t == -KJ) dcfg.spin_iterations = (std::uint32_t)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "drain_stall_ms", v) && v) {
+            if (v->t == -KI) dcfg.drain_stall_ms = (std::uint32_t)std::max(0, v->i);
+            else if (v->t == -KJ) dcfg.drain_stall_ms = (std::uint32_t)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "partition_high_watermark", v) && v) {
+            if (v->t == -KI) dcfg.partition_high_watermark = (std::size_t)std::max(0, v->i);
+            else if (v->t == -KJ) dcfg.partition_high_watermark = (std::size_t)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "partition_low_watermark", v) && v) {
+            if (v->t == -KI) dcfg.partition_low_watermark = (std::size_t)std::max(0, v->i);
+            else if (v->t == -KJ) dcfg.partition_low_watermark = (std::size_t)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "zero_copy", v) && v) {
+            if (v->t == -KB) dcfg.zero_copy = (bool)v->g;
+            else if (v->t == -KI) dcfg.zero_copy = (v->i != 0);
+            else if (v->t == -KJ) dcfg.zero_copy = (v->j != 0);
+            else dcfg.zero_copy = (k_to_string(v) == "true");
+        }
+
         // kafka (accept both bootstrap.servers and metadata.broker.list)
         if (dict_get(cfg, "bootstrap.servers", v) && v) {
             kcfg.bootstrap_servers = k_to_string(v);
@@ -127,6 +236,102 @@ namespace {
             else kcfg.enable_auto_commit = (k_to_string(v) == "true");
         }
 
+        if (dict_get(cfg, "shared_nothing", v) && v) {
+            if (v->t == -KB) dcfg.shared_nothing = (bool)v->g;
+            else if (v->t == -KI) dcfg.shared_nothing = (v->i != 0);
+            else if (v->t == -KJ) dcfg.shared_nothing = (v->j != 0);
+            else dcfg.shared_nothing = (k_to_string(v) == "true");
+        }
+
+        if (dict_get(cfg, "consumer_cpus", v) && v) dcfg.consumer_cpus = k_to_string(v);
+        if (dict_get(cfg, "decoder_cpus", v) && v) dcfg.decoder_cpus = k_to_string(v);
+        if (dict_get(cfg, "numa_local", v) && v) {
+            if (v->t == -KB) dcfg.numa_local = (bool)v->g;
+            else if (v->t == -KI) dcfg.numa_local = (v->i != 0);
+            else if (v->t == -KJ) dcfg.numa_local = (v->j != 0);
+            else dcfg.numa_local = (k_to_string(v) == "true");
+        }
+        if (dict_get(cfg, "huge_pages", v) && v) {
+            if (v->t == -KB) dcfg.huge_pages = (bool)v->g;
+            else if (v->t == -KI) dcfg.huge_pages = (v->i != 0);
+            else if (v->t == -KJ) dcfg.huge_pages = (v->j != 0);
+            else dcfg.huge_pages = (k_to_string(v) == "true");
+        }
+
+        if (dict_get(cfg, "latency_stats", v) && v) {
+            if (v->t == -KB) dcfg.latency_stats = (bool)v->g;
+            else if (v->t == -KI) dcfg.latency_stats = (v->i != 0);
+            else if (v->t == -KJ) dcfg.latency_stats = (v->j != 0);
+            else dcfg.latency_stats = (k_to_string(v) == "true");
+        }
+
+        if (dict_get(cfg, "decoder_stats", v) && v) {
+            if (v->t == -KB) dcfg.decoder_stats = (bool)v->g;
+            else if (v->t == -KI) dcfg.decoder_stats = (v->i != 0);
+            else if (v->t == -KJ) dcfg.decoder_stats = (v->j != 0);
+            else dcfg.decoder_stats = (k_to_string(v) == "true");
+        }
+
+        if (dict_get(cfg, "flight_recorder", v) && v) {
+            if (v->t == -KI) dcfg.flight_recorder = (std::size_t)std::max(0, v->i);
+            else if (v->t == -KJ) dcfg.flight_recorder = (std::size_t)std::max<J>(0, v->j);
+        }
+
+        if (dict_get(cfg, "commit_on_drain", v) && v) {
+            if (v->t == -KB) kcfg.commit_on_drain = (bool)v->g;
+            else if (v->t == -KI) kcfg.commit_on_drain = (v->i != 0);
+            else if (v->t == -KJ) kcfg.commit_on_drain = (v->j != 0);
+            else kcfg.commit_on_drain = (k_to_string(v) == "true");
+        }
+        if (dict_get(cfg, "commit_interval_ms", v) && v) {
+            if (v->t == -KI) kcfg.commit_interval_ms = (std::uint32_t)std::max(1, v->i);
+            else if (v->t == -KJ) kcfg.commit_interval_ms = (std::uint32_t)std::max<J>(1, v->j);
+        }
+
+        if (dict_get(cfg, "stats_interval_ms", v) && v) {
+            if (v->t == -KI) kcfg.stats_interval_ms = (std::uint32_t)std::max(0, v->i);
+            else if (v->t == -KJ) kcfg.stats_interval_ms = (std::uint32_t)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "prometheus_file", v) && v) kcfg.prometheus_file = k_to_string(v);
+
+        // message source: kafka (default), synthetic or replay (capture file)
+        if (dict_get(cfg, "source", v) && v) {
+            auto s = k_to_string(v);
+            if (s == "kafka") scfg.kind = kafkax::SourceConfig::Kind::Kafka;
+            else if (s == "synthetic") scfg.kind = kafkax::SourceConfig::Kind::Synthetic;
+            else if (s == "replay") scfg.kind = kafkax::SourceConfig::Kind::Replay;
+            else {
+                err = "source: expected kafka, synthetic or replay, got '" + s + "'";
+                return false;
+            }
+        }
+        if (dict_get(cfg, "replay_file", v) && v) scfg.path = k_to_string(v);
+        if (dict_get(cfg, "replay_speed", v) && v) {
+            if (v->t == -KF) scfg.speed = std::max(0.0, v->f);
+            else if (v->t == -KI) scfg.speed = (double)std::max(0, v->i);
+            else if (v->t == -KJ) scfg.speed = (double)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "synthetic_count", v) && v) {
+            if (v->t == -KI) scfg.count = (std::uint64_t)std::max(0, v->i);
+            else if (v->t == -KJ) scfg.count = (std::uint64_t)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "synthetic_rate", v) && v) {
+            if (v->t == -KI) scfg.rate = (std::uint64_t)std::max(0, v->i);
+            else if (v->t == -KJ) scfg.rate = (std::uint64_t)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "synthetic_size", v) && v) {
+            if (v->t == -KI) scfg.payload_size = (std::size_t)std::max(0, v->i);
+            else if (v->t == -KJ) scfg.payload_size = (std::size_t)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "synthetic_key_size", v) && v) {
+            if (v->t == -KI) scfg.key_size = (std::size_t)std::max(0, v->i);
+            else if (v->t == -KJ) scfg.key_size = (std::size_t)std::max<J>(0, v->j);
+        }
+        if (dict_get(cfg, "synthetic_partitions", v) && v) {
+            if (v->t == -KI) scfg.partitions = std::max(1, v->i);
+            else if (v->t == -KJ) scfg.partitions = (std::int32_t)std::max<J>(1, v->j);
+        }
+
         // extra: everything else stringified
         K keys = kK(cfg)[0];
         K vals = kK(cfg)[1];
@@ -134,12 +339,28 @@ namespace {
             for (J i = 0; i < keys->n; ++i) {
                 std::string key = kS(keys)[i];
                 if (key == "decode_threads" || key == "raw_queue_size" || key == "evt_queue_size" ||
+                    key == "route_policy" || key == "zero_copy" ||
+                    key == "consume_batch" || key == "consume_timeout_ms" || key == "catchup_batch" ||
+                    key == "work_stealing" || key == "steal_threshold" ||
+                    key == "wait_strategy" || key == "spin_iterations" ||
+                    key == "drain_stall_ms" ||
+                    key == "partition_high_watermark" || key == "partition_low_watermark" ||
                     key == "bootstrap.servers" || key == "metadata.broker.list" ||
-                    key == "group.id" || key == "auto.offset.reset" || key == "enable.auto.commit")
+                    key == "group.id" || key == "auto.offset.reset" || key == "enable.auto.commit" ||
+                    key == "commit_on_drain" || key == "commit_interval_ms" ||
+                    key == "shared_nothing" ||
+                    key == "consumer_cpus" || key == "decoder_cpus" ||
+                    key == "numa_local" || key == "huge_pages" ||
+                    key == "latency_stats" || key == "decoder_stats" || key == "flight_recorder" ||
+                    key == "stats_interval_ms" || key == "prometheus_file" ||
+                    key == "source" || key == "replay_file" || key == "replay_speed" ||
+                    key == "synthetic_count" || key == "synthetic_rate" || key == "synthetic_size" ||
+                    key == "synthetic_key_size" || key == "synthetic_partitions")
                     continue;
                 kcfg.extra[key] = k_to_string(kK(vals)[i]);
             }
         }
+        return true;
     }
 
     // sd1 callback: q main thread calls this when fd readable.
@@ -170,9 +391,11 @@ extern "C" {
     K kfkx_initconsumer(K cfg) {
         kafkax::Core::DecodeConfig dcfg{};
         kafkax::Core::KafkaConfig  kcfg{};
-        parse_cfg(cfg, dcfg, kcfg);
+        kafkax::SourceConfig       scfg{};
 
         std::string err;
+        if (!parse_cfg(cfg, dcfg, kcfg, scfg, err)) return krr((S)ss((S)err.c_str()));
+
         std::unique_ptr<kafkax::Core> core;
 
         try {
@@ -183,6 +406,12 @@ extern "C" {
             return krr((S)"Core() failed");
         }
 
+        if (scfg.kind != kafkax::SourceConfig::Kind::Kafka) {
+            auto src = kafkax::make_source(scfg, err);
+            if (!src || core->set_source(std::move(src), err) != 0)
+                return krr((S)ss((S)err.c_str()));
+        }
+
         int handle = g_next_handle.fetch_add(1);
 
         {
@@ -331,17 +560,361 @@ extern "C" {
         return ki(1);
     }
 
+    // kfkx_seek(handle; topics; pos) -> 1
+    // topics: symbol atom or list (` = every assigned topic)
+    // pos: timestamp      -> first message at/after it, per partition
+    //      `beginning`end -> earliest / latest
+    //      partition!offset dict (ints/longs) -> explicit offsets, topics must be one symbol
+    K kfkx_seek(K h, K topics, K pos) {
+        int handle = get_handle(h);
+        if (handle <= 0) return krr((S)"bad handle");
+
+        std::vector<std::string> ts;
+        if (k_is_sym_atom(topics)) {
+            if (topics->s && topics->s[0]) ts.emplace_back(topics->s);
+        } else if (k_is_sym_vec(topics)) {
+            for (J i = 0; i < topics->n; ++i) ts.emplace_back(kS(topics)[i]);
+        } else return krr((S)"topics must be symbol atom or symbol list");
+
+        kafkax::Core* core = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            auto it = g_entries.find(handle);
+            if (it == g_entries.end()) return krr((S)"unknown handle");
+            core = it->second.core.get();
+        }
+
+        std::string err;
+        int rc = 0;
+
+        if (pos && pos->t == -KP) {
+            // q timestamps count ns from 2000.01.01
+            const J unix_ms = pos->j / 1000000 + 946684800000LL;
+            rc = core->seek_to_timestamp((std::int64_t)unix_ms, ts, err);
+        } else if (k_is_sym_atom(pos)) {
+            // ListOffsets special timestamps: -2 earliest, -1 latest
+            const std::string where = pos->s;
+            if (where == "beginning") rc = core->seek_to_timestamp(-2, ts, err);
+            else if (where == "end")  rc = core->seek_to_timestamp(-1, ts, err);
+            else return krr((S)"pos symbol must be `beginning or `end");
+        } else if (k_is_dict(pos)) {
+            if (ts.size() != 1) return krr((S)"offset dict needs exactly one topic");
+
+            K ps = kK(pos)[0];
+            K os = kK(pos)[1];
+            if (!((ps->t == KI || ps->t == KJ) && (os->t == KI || os->t == KJ)))
+                return krr((S)"offset dict must map int/long partitions to int/long offsets");
+
+            std::vector<kafkax::Core::SeekTarget> targets;
+            targets.reserve((std::size_t)ps->n);
+            for (J i = 0; i < ps->n; ++i) {
+                kafkax::Core::SeekTarget t;
+                t.topic = ts[0];
+                t.partition = ps->t == KI ? kI(ps)[i] : (std::int32_t)kJ(ps)[i];
+                t.offset = os->t == KI ? kI(os)[i] : kJ(os)[i];
+                targets.push_back(std::move(t));
+            }
+            rc = core->seek_to_offsets(targets, err);
+        } else {
+            return krr((S)"pos must be timestamp, `beginning`end or partition!offset dict");
+        }
+
+        if (rc != 0) return krr((S)err.c_str());
+        return ki(1);
+    }
+
+    // kfkx_stats(handle) -> table: metric label partition value
+    // label is the topic or broker (` for global counters), partition 0Ni if n/a
+    K kfkx_stats(K h) {
+        int handle = get_handle(h);
+        if (handle <= 0) return krr((S)"bad handle");
+
+        kafkax::Core* core = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            auto it = g_entries.find(handle);
+            if (it == g_entries.end()) return krr((S)"unknown handle");
+            core = it->second.core.get();
+        }
+
+        kafkax::Metrics m;
+        core->metrics(m);
+
+        std::vector<kafkax::MetricSample> samples;
+        kafkax::flatten_metrics(m, samples);
+
+        J n = (J)samples.size();
+        K col_metric = ktn(KS, n);
+        K col_label  = ktn(KS, n);
+        K col_part   = ktn(KI, n);
+        K col_value  = ktn(KF, n);
+
+        for (J i = 0; i < n; ++i) {
+            const auto& s = samples[(size_t)i];
+            kS(col_metric)[i] = ss((S)s.name);
+            kS(col_label)[i]  = ss((S)s.label.c_str());
+            kI(col_part)[i]   = s.partition >= 0 ? (I)s.partition : ni;
+            kF(col_value)[i]  = s.value;
+        }
+
+        K names = ktn(KS, 4);
+        kS(names)[0] = ss((S)"metric");
+        kS(names)[1] = ss((S)"label");
+        kS(names)[2] = ss((S)"partition");
+        kS(names)[3] = ss((S)"value");
+
+        return xT(xD(names, knk(4, col_metric, col_label, col_part, col_value)));
+    }
+
+    // kfkx_latency(handle) -> table: topic stage count p50 p90 p99 p999 max
+    // percentiles are timespans; empty unless latency_stats was set
+    K kfkx_latency(K h) {
+        int handle = get_handle(h);
+        if (handle <= 0) return krr((S)"bad handle");
+
+        kafkax::Core* core = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            auto it = g_entries.find(handle);
+            if (it == g_entries.end()) return krr((S)"unknown handle");
+            core = it->second.core.get();
+        }
+
+        std::vector<kafkax::LatencyRow> rows;
+        core->latency(rows);
+
+        J n = (J)rows.size();
+        K col_topic = ktn(KS, n);
+        K col_stage = ktn(KS, n);
+        K col_count = ktn(KJ, n);
+        K col_p50   = ktn(KN, n);
+        K col_p90   = ktn(KN, n);
+        K col_p99   = ktn(KN, n);
+        K col_p999  = ktn(KN, n);
+        K col_max   = ktn(KN, n);
+
+        for (J i = 0; i < n; ++i) {
+            const auto& r = rows[(size_t)i];
+            kS(col_topic)[i] = ss((S)core->topic_name(r.topic_id).c_str());
+            kS(col_stage)[i] = ss((S)kafkax::latency_stage_name(r.stage));
+            kJ(col_count)[i] = (J)r.count;
+            kJ(col_p50)[i]   = (J)r.p50;
+            kJ(col_p90)[i]   = (J)r.p90;
+            kJ(col_p99)[i]   = (J)r.p99;
+            kJ(col_p999)[i]  = (J)r.p999;
+            kJ(col_max)[i]   = (J)r.max;
+        }
+
+        K names = ktn(KS, 8);
+        kS(names)[0] = ss((S)"topic");
+        kS(names)[1] = ss((S)"stage");
+        kS(names)[2] = ss((S)"count");
+        kS(names)[3] = ss((S)"p50");
+        kS(names)[4] = ss((S)"p90");
+        kS(names)[5] = ss((S)"p99");
+        kS(names)[6] = ss((S)"p999");
+        kS(names)[7] = ss((S)"max");
+
+        return xT(xD(names, knk(8, col_topic, col_stage, col_count,
+                                col_p50, col_p90, col_p99, col_p999, col_max)));
+    }
+
+    // kfkx_decoders(handle) -> table: topic binding so_path symbol current
+    //   calls total avg max bytes_in bytes_out retries errors
+    // one row per (topic, binding) that has decoded; current is false for a
+    // binding since replaced by rebind, so old and new plugins sit side by side
+    K kfkx_decoders(K h) {
+        int handle = get_handle(h);
+        if (handle <= 0) return krr((S)"bad handle");
+
+        kafkax::Core* core = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            auto it = g_entries.find(handle);
+            if (it == g_entries.end()) return krr((S)"unknown handle");
+            core = it->second.core.get();
+        }
+
+        std::vector<kafkax::DecoderCost> rows;
+        core->decoder_costs(rows);
+        std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+            return a.topic_id != b.topic_id ? a.topic_id < b.topic_id : a.binding < b.binding;
+        });
+
+        J n = (J)rows.size();
+        K col_topic   = ktn(KS, n);
+        K col_binding = ktn(KJ, n);
+        K col_so      = ktn(KS, n);
+        K col_symbol  = ktn(KS, n);
+        K col_current = ktn(KB, n);
+        K col_calls   = ktn(KJ, n);
+        K col_total   = ktn(KN, n);
+        K col_avg     = ktn(KN, n);
+        K col_max     = ktn(KN, n);
+        K col_in      = ktn(KJ, n);
+        K col_out     = ktn(KJ, n);
+        K col_retries = ktn(KJ, n);
+        K col_errors  = ktn(KJ, n);
+
+        for (J i = 0; i < n; ++i) {
+            const auto& r = rows[(size_t)i];
+            const auto& topic = core->topic_name(r.topic_id);
+
+            kafkax::DecoderRegistry::BindingInfo bi{}, cur{};
+            core->binding_info(r.binding, bi);
+            const bool current = core->get_topic_decoder(topic, cur) && cur.id == r.binding;
+
+            kS(col_topic)[i]   = ss((S)topic.c_str());
+            kJ(col_binding)[i] = (J)r.binding;
+            kS(col_so)[i]      = ss((S)bi.so_path.c_str());
+            kS(col_symbol)[i]  = ss((S)bi.symbol.c_str());
+            kG(col_current)[i] = current ? 1 : 0;
+            kJ(col_calls)[i]   = (J)r.calls;
+            kJ(col_total)[i]   = (J)r.total_ns;
+            kJ(col_avg)[i]     = r.calls ? (J)(r.total_ns / r.calls) : nj;
+            kJ(col_max)[i]     = (J)r.max_ns;
+            kJ(col_in)[i]      = (J)r.bytes_in;
+            kJ(col_out)[i]     = (J)r.bytes_out;
+            kJ(col_retries)[i] = (J)r.retries;
+            kJ(col_errors)[i]  = (J)r.errors;
+        }
+
+        K names = ktn(KS, 13);
+        kS(names)[0]  = ss((S)"topic");
+        kS(names)[1]  = ss((S)"binding");
+        kS(names)[2]  = ss((S)"so_path");
+        kS(names)[3]  = ss((S)"symbol");
+        kS(names)[4]  = ss((S)"current");
+        kS(names)[5]  = ss((S)"calls");
+        kS(names)[6]  = ss((S)"total");
+        kS(names)[7]  = ss((S)"avg");
+        kS(names)[8]  = ss((S)"max");
+        kS(names)[9]  = ss((S)"bytes_in");
+        kS(names)[10] = ss((S)"bytes_out");
+        kS(names)[11] = ss((S)"retries");
+        kS(names)[12] = ss((S)"errors");
+
+        return xT(xD(names, knk(13, col_topic, col_binding, col_so, col_symbol, col_current,
+                                col_calls, col_total, col_avg, col_max,
+                                col_in, col_out, col_retries, col_errors)));
+    }
+
+    // kfkx_recent(handle; topic) -> table: ts worker topic partition offset
+    //   status decode len prefix err
+    // the flight recorder, oldest first; ` (null symbol) for every topic.
+    // prefix is the first 64 payload bytes, len the full payload length.
+    K kfkx_recent(K h, K topicK) {
+        int handle = get_handle(h);
+        if (handle <= 0) return krr((S)"bad handle");
+        if (!k_is_sym_atom(topicK)) return krr((S)"topic must be a symbol");
+
+        kafkax::Core* core = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            auto it = g_entries.find(handle);
+            if (it == g_entries.end()) return krr((S)"unknown handle");
+            core = it->second.core.get();
+        }
+
+        std::vector<kafkax::FlightRecord> recs;
+        core->recent(topicK->s ? topicK->s : "", recs);
+
+        J n = (J)recs.size();
+        K col_ts     = ktn(KP, n);
+        K col_worker = ktn(KI, n);
+        K col_topic  = ktn(KS, n);
+        K col_part   = ktn(KI, n);
+        K col_offset = ktn(KJ, n);
+        K col_status = ktn(KS, n);
+        K col_decode = ktn(KN, n);
+        K col_len    = ktn(KJ, n);
+        K col_prefix = ktn(0, n);
+        K col_err    = ktn(0, n);
+
+        for (J i = 0; i < n; ++i) {
+            const auto& r = recs[(size_t)i];
+            // q timestamps count ns from 2000.01.01
+            kJ(col_ts)[i]     = (J)r.ts_ns - 946684800000000000LL;
+            kI(col_worker)[i] = (I)r.worker;
+            kS(col_topic)[i]  = ss((S)core->topic_name(r.topic_id).c_str());
+            kI(col_part)[i]   = (I)r.partition;
+            kJ(col_offset)[i] = (J)r.offset;
+            kS(col_status)[i] = ss((S)(r.status == kafkax::FlightRecord::Ok ? "ok" : "error"));
+            kJ(col_decode)[i] = (J)r.decode_ns;
+            kJ(col_len)[i]    = (J)r.payload_len;
+
+            K pre = ktn(KG, r.prefix_len);
+            if (r.prefix_len) std::memcpy(kG(pre), r.prefix, r.prefix_len);
+            kK(col_prefix)[i] = pre;
+            kK(col_err)[i]    = kpn((S)r.err, (J)r.err_len);
+        }
+
+        K names = ktn(KS, 10);
+        kS(names)[0] = ss((S)"ts");
+        kS(names)[1] = ss((S)"worker");
+        kS(names)[2] = ss((S)"topic");
+        kS(names)[3] = ss((S)"partition");
+        kS(names)[4] = ss((S)"offset");
+        kS(names)[5] = ss((S)"status");
+        kS(names)[6] = ss((S)"decode");
+        kS(names)[7] = ss((S)"len");
+        kS(names)[8] = ss((S)"prefix");
+        kS(names)[9] = ss((S)"err");
+
+        return xT(xD(names, knk(10, col_ts, col_worker, col_topic, col_part, col_offset,
+                                col_status, col_decode, col_len, col_prefix, col_err)));
+    }
+
+    // kfkx_dumprecent(handle; path) -> path; the flight recorder as text
+    K kfkx_dumprecent(K h, K pathK) {
+        int handle = get_handle(h);
+        if (handle <= 0) return krr((S)"bad handle");
+
+        const auto path = k_to_string(pathK);
+        if (path.empty()) return krr((S)"path must be a symbol or string");
+
+        kafkax::Core* core = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            auto it = g_entries.find(handle);
+            if (it == g_entries.end()) return krr((S)"unknown handle");
+            core = it->second.core.get();
+        }
+
+        std::string err;
+        if (!core->dump_recent(path, err)) return krr((S)ss((S)err.c_str()));
+        return ks((S)path.c_str());
+    }
+
+    // kfkx_finished(handle) -> boolean; a replay/synthetic source ran dry and all of it was drained
+    K kfkx_finished(K h) {
+        int handle = get_handle(h);
+        if (handle <= 0) return krr((S)"bad handle");
+
+        kafkax::Core* core = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            auto it = g_entries.find(handle);
+            if (it == g_entries.end()) return krr((S)"unknown handle");
+            core = it->second.core.get();
+        }
+
+        return kb(core->source_finished());
+    }
+
     // kfkx_drain(handle; limit) -> table: tbl topic kind data err
     K kfkx_drain(K h, K limitK) {
         int handle = get_handle(h);
         if (handle <= 0) return krr((S)"bad handle");
 
+        Entry* ent = nullptr;
         kafkax::Core* core = nullptr;
         int efd = -1;
         {
             std::lock_guard<std::mutex> lk(g_mu);
             auto it = g_entries.find(handle);
             if (it == g_entries.end()) return krr((S)"unknown handle");
+            ent  = &it->second;
             core = it->second.core.get();
             efd  = it->second.efd;
         }
@@ -354,12 +927,18 @@ extern "C" {
 
         if (efd >= 0) drain_eventfd(efd);
 
-        std::vector<kafkax::Event> evs;
+        auto& evs = ent->drained;
         evs.reserve(limit);
         core->drainTo(evs, limit);
 
         J n = (J)evs.size();
 
+        auto gen = core->binding_generation();
+        if (gen != ent->tbl_gen) {
+            std::fill(ent->tbl_syms.begin(), ent->tbl_syms.end(), nullptr);
+            ent->tbl_gen = gen;
+        }
+
         K col_tbl   = ktn(KS, n);
         K col_topic = ktn(KS, n);
         K col_kind  = ktn(KS, n);
@@ -369,15 +948,7 @@ extern "C" {
         for (J i = 0; i < n; ++i) {
             const auto& ev = evs[(size_t)i];
 
-            kS(col_topic)[i] = ss((S)ev.topic.c_str());
-
-            kafkax::DecoderRegistry::BindingInfo bi{};
-            if (core->get_topic_decoder(ev.topic, bi)) {
-                // adjust if your field name differs
-                kS(col_tbl)[i] = ss((S)bi.symbol.c_str());
-            } else {
-                kS(col_tbl)[i] = ss((S)ev.topic.c_str());
-            }
+            topic_syms_for(*ent, ev.topic_id, kS(col_topic)[i], kS(col_tbl)[i]);
 
             if (ev.kind == kafkax::Event::Kind::Error) {
                 kS(col_kind)[i] = ss((S)"error");
@@ -386,8 +957,9 @@ extern "C" {
                 kK(col_err)[i]  = k_errvec(ev.err_msg, sizeof(ev.err_msg));
             } else {
                 kS(col_kind)[i] = ss((S)"data");
-                K b = ktn(KG, (J)ev.bytes.size());
-                if (!ev.bytes.empty()) std::memcpy(kG(b), ev.bytes.data(), ev.bytes.size());
+                auto payload = ev.payload();
+                K b = ktn(KG, (J)payload.size());
+                if (!payload.empty()) std::memcpy(kG(b), payload.data(), payload.size());
                 kK(col_data)[i] = b;
                 kK(col_err)[i]  = ktn(KC, 0);
             }
@@ -400,6 +972,8 @@ extern "C" {
         kS(names)[3] = ss((S)"data");
         kS(names)[4] = ss((S)"err");
 
+        core->recycle(evs);
+
         return xT(xD(names, knk(5, col_tbl, col_topic, col_kind, col_data, col_err)));
     }
 
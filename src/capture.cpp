@@ -0,0 +1,159 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#include "kafkax/capture.hpp"
+
+namespace kafkax {
+
+    namespace {
+        constexpr char kMagic[8] = {'K', 'F', 'K', 'X', 'C', 'A', 'P', '1'};
+
+        struct RecordHeader {
+            std::uint32_t topic_len;
+            std::uint32_t key_len;
+            std::uint32_t payload_len;
+            std::int32_t partition;
+            std::int64_t offset;
+            std::int64_t timestamp_ms;
+        };
+        static_assert(sizeof(RecordHeader) == 32);
+    } // namespace
+
+    CaptureReader::~CaptureReader()
+    {
+        close();
+    }
+
+    bool CaptureReader::open(const std::string& path, std::string& err)
+    {
+        close();
+
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            err = path + ": " + std::strerror(errno);
+            return false;
+        }
+
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            err = path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+
+        const auto len = static_cast<std::size_t>(st.st_size);
+        if (len < kMagicLen) {
+            err = path + ": not a capture file";
+            ::close(fd);
+            return false;
+        }
+
+        void* p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            err = path + ": " + std::strerror(errno);
+            return false;
+        }
+
+        if (std::memcmp(p, kMagic, kMagicLen) != 0) {
+            ::munmap(p, len);
+            err = path + ": not a capture file";
+            return false;
+        }
+
+        (void)::madvise(p, len, MADV_SEQUENTIAL);
+        base_ = static_cast<const std::uint8_t*>(p);
+        len_ = len;
+        pos_ = kMagicLen;
+        return true;
+    }
+
+    void CaptureReader::close() noexcept
+    {
+        if (base_) ::munmap(const_cast<std::uint8_t*>(base_), len_);
+        base_ = nullptr;
+        len_ = 0;
+        pos_ = 0;
+    }
+
+    bool CaptureReader::next(CaptureRecord& out) noexcept
+    {
+        if (!base_ || len_ - pos_ < sizeof(RecordHeader)) return false;
+
+        RecordHeader h;
+        std::memcpy(&h, base_ + pos_, sizeof(h));
+
+        const std::size_t body = std::size_t{h.topic_len} + h.key_len + h.payload_len;
+        if (len_ - pos_ - sizeof(h) < body) return false;
+
+        const auto* p = base_ + pos_ + sizeof(h);
+        out.topic = std::string_view(reinterpret_cast<const char*>(p), h.topic_len);
+        p += h.topic_len;
+        out.key = std::span<const std::uint8_t>(p, h.key_len);
+        p += h.key_len;
+        out.payload = std::span<const std::uint8_t>(p, h.payload_len);
+        out.partition = h.partition;
+        out.offset = h.offset;
+        out.timestamp_ms = h.timestamp_ms;
+
+        pos_ += sizeof(h) + body;
+        return true;
+    }
+
+    CaptureWriter::~CaptureWriter()
+    {
+        std::string ignored;
+        (void)close(ignored);
+    }
+
+    bool CaptureWriter::open(const std::string& path, std::string& err)
+    {
+        if (!close(err)) return false;
+
+        f_ = std::fopen(path.c_str(), "wb");
+        if (!f_) {
+            err = path + ": " + std::strerror(errno);
+            return false;
+        }
+        path_ = path;
+        ok_ = std::fwrite(kMagic, 1, sizeof(kMagic), f_) == sizeof(kMagic);
+        return ok_;
+    }
+
+    bool CaptureWriter::append(const CaptureRecord& rec) noexcept
+    {
+        if (!f_ || !ok_) return false;
+
+        const RecordHeader h{
+            static_cast<std::uint32_t>(rec.topic.size()),
+            static_cast<std::uint32_t>(rec.key.size()),
+            static_cast<std::uint32_t>(rec.payload.size()),
+            rec.partition,
+            rec.offset,
+            rec.timestamp_ms};
+
+        ok_ = std::fwrite(&h, sizeof(h), 1, f_) == 1 &&
+              std::fwrite(rec.topic.data(), 1, rec.topic.size(), f_) == rec.topic.size() &&
+              std::fwrite(rec.key.data(), 1, rec.key.size(), f_) == rec.key.size() &&
+              std::fwrite(rec.payload.data(), 1, rec.payload.size(), f_) == rec.payload.size();
+        return ok_;
+    }
+
+    bool CaptureWriter::close(std::string& err)
+    {
+        if (!f_) return true;
+
+        const bool closed = std::fclose(f_) == 0;
+        f_ = nullptr;
+        if (!ok_ || !closed) {
+            err = path_ + ": write failed";
+            return false;
+        }
+        return true;
+    }
+
+} // namespace kafkax
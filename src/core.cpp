@@ -1,48 +1,98 @@
 #include <sys/eventfd.h>
 #include <unistd.h>
 #include <errno.h>
+#include <algorithm>
+#include <bit>
+#include <chrono>
 #include <cstring>
+#include <new>
+#include <stdexcept>
 
 #include "kafkax/core.hpp"
+#include "kafkax/trace.hpp"
 
 namespace kafkax {
+    void MsgRelease::operator()(rd_kafka_message_s* msg) const noexcept {
+        if (msg) release_message(msg);
+    }
+
     inline const char* bool_to_str(bool b) {
         return b ? "true" : "false";
     }
 
+    inline std::int64_t mono_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
     namespace detail {
         template <class T>
-        SPSCRing<T>::SPSCRing(std::size_t cap)
-            : cap_(cap == 0 ? 1 : cap),
-              buf_(static_cast<T*>(::operator new[](sizeof(T) * cap_))) {}
+        SPSCRing<T>::SPSCRing(std::size_t cap, const placement::MemPolicy& mem)
+            : cap_(std::bit_ceil(cap == 0 ? std::size_t{1} : cap)),
+              mask_(cap_ - 1),
+              mem_(mem)
+        {
+            if (!mem_.is_default()) {
+                buf_ = static_cast<T*>(placement::alloc_pages(sizeof(T) * cap_, mem_));
+                if (!buf_) throw std::bad_alloc();
+            } else {
+                buf_ = static_cast<T*>(::operator new[](sizeof(T) * cap_));
+            }
+        }
 
         template <class T>
         SPSCRing<T>::~SPSCRing() {
             T tmp;
             while (try_pop(tmp)) {}
-            ::operator delete[](buf_);
+            if (!mem_.is_default())
+                placement::free_pages(buf_, sizeof(T) * cap_, mem_);
+            else
+                ::operator delete[](buf_);
         }
 
         template <class T>
         bool SPSCRing<T>::try_push(T&& v) {
             auto t = tail_.load(std::memory_order_relaxed);
-            auto h = head_.load(std::memory_order_acquire);
 
-            if ((t - h) >= cap_) return false;
+            if ((t - head_cache_) >= cap_) {
+                head_cache_ = head_.load(std::memory_order_acquire);
+                if ((t - head_cache_) >= cap_) return false;
+            }
 
-            new (&buf_[t % cap_]) T(std::move(v));
+            new (&buf_[t & mask_]) T(std::move(v));
             tail_.store(t + 1, std::memory_order_release);
             return true;
         }
 
+        template <class T>
+        std::size_t SPSCRing<T>::try_push_n(std::span<T> items) {
+            auto t = tail_.load(std::memory_order_relaxed);
+
+            auto room = cap_ - (t - head_cache_);
+            if (room < items.size()) {
+                head_cache_ = head_.load(std::memory_order_acquire);
+                room = cap_ - (t - head_cache_);
+            }
+
+            const auto n = std::min<std::size_t>(room, items.size());
+            for (std::size_t i = 0; i < n; ++i) {
+                new (&buf_[(t + i) & mask_]) T(std::move(items[i]));
+            }
+
+            if (n) tail_.store(t + n, std::memory_order_release);
+            return n;
+        }
+
         template <class T>
         bool SPSCRing<T>::try_pop(T& out) {
             auto h = head_.load(std::memory_order_relaxed);
-            auto t = tail_.load(std::memory_order_acquire);
 
-            if (h == t) return false;
+            if (h == tail_cache_) {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+                if (h == tail_cache_) return false;
+            }
 
-            T* slot = &buf_[h % cap_];
+            T* slot = &buf_[h & mask_];
             out = std::move(*slot);
             slot->~T();
 
@@ -50,12 +100,98 @@ namespace kafkax {
             return true;
         }
 
+        template <class T>
+        std::size_t SPSCRing<T>::try_pop_n(std::span<T> out) {
+            auto h = head_.load(std::memory_order_relaxed);
+
+            auto avail = tail_cache_ - h;
+            if (avail < out.size()) {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+                avail = tail_cache_ - h;
+            }
+
+            const auto n = std::min<std::size_t>(avail, out.size());
+            for (std::size_t i = 0; i < n; ++i) {
+                T* slot = &buf_[(h + i) & mask_];
+                out[i] = std::move(*slot);
+                slot->~T();
+            }
+
+            if (n) head_.store(h + n, std::memory_order_release);
+            return n;
+        }
+
         template <class T>
         std::size_t SPSCRing<T>::size() const noexcept {
-            return tail_.load() - head_.load();
+            // head first: tail can only grow meanwhile, so this never underflows
+            auto h = head_.load(std::memory_order_acquire);
+            auto t = tail_.load(std::memory_order_acquire);
+            return static_cast<std::size_t>(t - h);
         }
 
-        template class SPSCRing<std::unique_ptr<Core::RawMsg>>;
+        namespace {
+            inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#elif defined(__aarch64__)
+                asm volatile("yield" ::: "memory");
+#endif
+            }
+        } // namespace
+
+        void WaitPoint::wait(std::uint64_t seen) noexcept {
+            if (closed_.load(std::memory_order_seq_cst)) return;
+
+            switch (strategy_) {
+                case WaitStrategy::BusyPoll:
+                    while (epoch_.load(std::memory_order_acquire) == seen) cpu_relax();
+                    return;
+
+                case WaitStrategy::SpinThenPark:
+                    for (std::uint32_t i = 0; i < spins_; ++i) {
+                        if (epoch_.load(std::memory_order_acquire) != seen) return;
+                        cpu_relax();
+                    }
+                    /* announce before the final check; pairs with signal()'s
+                     * seq_cst bump + parked_ load so a wakeup cannot be missed */
+                    parked_.fetch_add(1, std::memory_order_seq_cst);
+                    if (epoch_.load(std::memory_order_seq_cst) == seen)
+                        epoch_.wait(seen, std::memory_order_acquire);
+                    parked_.fetch_sub(1, std::memory_order_relaxed);
+                    return;
+
+                case WaitStrategy::Blocking:
+                    epoch_.wait(seen, std::memory_order_acquire);
+                    return;
+            }
+        }
+
+        void WaitPoint::signal() noexcept {
+            switch (strategy_) {
+                case WaitStrategy::BusyPoll:
+                    epoch_.fetch_add(1, std::memory_order_release);
+                    return;
+
+                case WaitStrategy::SpinThenPark:
+                    epoch_.fetch_add(1, std::memory_order_seq_cst);
+                    if (parked_.load(std::memory_order_seq_cst) != 0)
+                        epoch_.notify_all();   // producer and consumer may both be parked here
+                    return;
+
+                case WaitStrategy::Blocking:
+                    epoch_.fetch_add(1);
+                    epoch_.notify_one();
+                    return;
+            }
+        }
+
+        void WaitPoint::close() noexcept {
+            closed_.store(true, std::memory_order_seq_cst);
+            epoch_.fetch_add(1, std::memory_order_seq_cst);
+            epoch_.notify_all();
+        }
+
+        template class SPSCRing<Core::RawMsg>;
         template class SPSCRing<std::unique_ptr<Event>>;
 
     } // namespace detail
@@ -67,12 +203,27 @@ namespace kafkax {
     Core::Core(const DecodeConfig& cfg)
     : cfg_(cfg) {
 
+        if (!placement::parse_cpu_list(cfg_.consumer_cpus, consumer_cpus_))
+            throw std::invalid_argument("bad consumer_cpus: " + cfg_.consumer_cpus);
+        if (!placement::parse_cpu_list(cfg_.decoder_cpus, decoder_cpus_))
+            throw std::invalid_argument("bad decoder_cpus: " + cfg_.decoder_cpus);
+
         high_watermark_ =
             static_cast<std::size_t>(cfg_.raw_queue_size * cfg_.high_watermark_ratio);
 
         low_watermark_ =
             static_cast<std::size_t>(cfg_.raw_queue_size * cfg_.low_watermark_ratio);
 
+        evt_high_watermark_ =
+            static_cast<std::size_t>(cfg_.evt_queue_size * cfg_.evt_high_watermark_ratio);
+
+        evt_low_watermark_ =
+            static_cast<std::size_t>(cfg_.evt_queue_size * cfg_.evt_low_watermark_ratio);
+
+        part_low_watermark_ = cfg_.partition_low_watermark != 0
+            ? cfg_.partition_low_watermark
+            : cfg_.partition_high_watermark / 2;
+
         conf_ = rd_kafka_conf_new();
 
         rd_kafka_conf_set_rebalance_cb(
@@ -85,7 +236,22 @@ namespace kafkax {
                 auto* self = static_cast<Core*>(opaque);
                 std::lock_guard<std::mutex> lk(self->assign_mu_);
 
+                // runs on the consumer thread (inside poll); a new assignment starts unpaused
+                for (auto& st : self->part_states_)
+                    st->paused = false;
+
+                if (self->ack_commit_) {
+                    // hand back what q already has before losing the partitions
+                    if (err != RD_KAFKA_RESP_ERR__ASSIGN_PARTITIONS)
+                        self->commit_acked(false);
+                    self->reset_ack_windows();
+                }
+
                 if (err == RD_KAFKA_RESP_ERR__ASSIGN_PARTITIONS) {
+                    // forward before fetching starts so nothing lands on the consumer queue
+                    if (self->cfg_.shared_nothing)
+                        self->forward_partitions(partitions, true);
+
                     rd_kafka_assign(rk, partitions);
 
                     if (self->assignment_)
@@ -95,6 +261,9 @@ namespace kafkax {
                         rd_kafka_topic_partition_list_copy(partitions);
                 }
                 else {
+                    if (self->cfg_.shared_nothing)
+                        self->forward_partitions(partitions, false);
+
                     rd_kafka_assign(rk, nullptr);
 
                     if (self->assignment_) {
@@ -104,6 +273,22 @@ namespace kafkax {
                 }
             });
 
+        rd_kafka_conf_set_error_cb(
+            conf_,
+            [](rd_kafka_t*, int err, const char* reason, void* opaque) {
+                auto* self = static_cast<Core*>(opaque);
+                self->kafka_errors_.fetch_add(1, std::memory_order_relaxed);
+                self->note_error(std::string(rd_kafka_err2str(static_cast<rd_kafka_resp_err_t>(err))) +
+                                 ": " + (reason ? reason : ""));
+            });
+
+        rd_kafka_conf_set_stats_cb(
+            conf_,
+            [](rd_kafka_t*, char* json, std::size_t len, void* opaque) {
+                static_cast<Core*>(opaque)->on_stats(json, len);
+                return 0;   // librdkafka frees json
+            });
+
         rd_kafka_conf_set_opaque(conf_, this);
     }
 
@@ -129,6 +314,15 @@ namespace kafkax {
                    const std::string& value,
                    std::string& err) {
 
+        if (source_ && !source_->is_kafka()) {
+            err = "set_conf: a non-kafka source is installed";
+            return -1;
+        }
+        if (!conf_) {
+            err = "set_conf: consumer already created";
+            return -1;
+        }
+
         char buf[256];
         auto r = rd_kafka_conf_set(conf_,
                                    key.c_str(),
@@ -162,7 +356,18 @@ namespace kafkax {
             return -1;
         }
 
-        if (set_conf("enable.auto.commit", bool_to_str(kafka_cfg.enable_auto_commit), err) != 0) {
+        ack_commit_ = kafka_cfg.commit_on_drain;
+        commit_interval_ms_ = kafka_cfg.commit_interval_ms;
+
+        if (kafka_cfg.stats_interval_ms > 0 &&
+            set_conf("statistics.interval.ms", std::to_string(kafka_cfg.stats_interval_ms), err) != 0)
+        {
+            return -1;
+        }
+        prometheus_file_ = kafka_cfg.prometheus_file;
+
+        const bool auto_commit = kafka_cfg.enable_auto_commit && !ack_commit_;
+        if (set_conf("enable.auto.commit", bool_to_str(auto_commit), err) != 0) {
             return -1;
         }
 
@@ -183,7 +388,14 @@ namespace kafkax {
             return -1;
         }
 
+        if (cfg_.shared_nothing && (cfg_.partition_high_watermark > 0 || ack_commit_)) {
+            err = "shared_nothing does not support partition_high_watermark or commit_on_drain";
+            return -1;
+        }
+
         for (const auto& topic : topics) {
+            topics_.intern(topic);
+
             if (registry_.get_fn(topic) != nullptr) {
                 continue;
             }
@@ -195,31 +407,44 @@ namespace kafkax {
                                        }
         }
 
-        char ebuf[512];
-        rk_ = rd_kafka_new(RD_KAFKA_CONSUMER, conf_, ebuf, sizeof(ebuf));
-        if (!rk_) { err = ebuf; return -1; }
-        conf_ = nullptr;
-
-        rd_kafka_poll_set_consumer(rk_);
+        if (!source_) {
+            char ebuf[512];
+            rk_ = rd_kafka_new(RD_KAFKA_CONSUMER, conf_, ebuf, sizeof(ebuf));
+            if (!rk_) { err = ebuf; return -1; }
+            conf_ = nullptr;
 
-        auto* list =
-            rd_kafka_topic_partition_list_new(topics.size());
+            rd_kafka_poll_set_consumer(rk_);
+            source_ = make_kafka_source(rk_);
+        }
 
-        for (auto& t : topics)
-            rd_kafka_topic_partition_list_add(
-                list,
-                t.c_str(),
-                RD_KAFKA_PARTITION_UA);
+        if (source_->subscribe(topics, err) != 0) {
+            return -1;
+        }
 
-        auto r = rd_kafka_subscribe(rk_, list);
-        rd_kafka_topic_partition_list_destroy(list);
+        start();
+        return 0;
+    }
 
-        if (r != RD_KAFKA_RESP_ERR_NO_ERROR) {
-            err = rd_kafka_err2str(r);
+    int Core::set_source(std::unique_ptr<MessageSource> src, std::string& err)
+    {
+        if (source_ || consumer_th_.joinable()) {
+            err = "set_source: already subscribed";
+            return -1;
+        }
+        if (!src || src->is_kafka()) {
+            err = "set_source: not a replay or synthetic source";
+            return -1;
+        }
+        if (cfg_.shared_nothing || cfg_.partition_high_watermark > 0 || ack_commit_) {
+            err = "set_source: shared_nothing, partition_high_watermark and commit_on_drain need Kafka";
             return -1;
         }
 
-        start();
+        source_ = std::move(src);
+        kafka_conf_ok_ = true;   // the Kafka config is not used
+
+        rd_kafka_conf_destroy(conf_);
+        conf_ = nullptr;
         return 0;
     }
 
@@ -233,22 +458,82 @@ namespace kafkax {
 
         raw_qs_.resize(cfg_.decode_threads);
         evt_qs_.resize(cfg_.decode_threads);
+        free_qs_.resize(cfg_.decode_threads);
         raw_epochs_.resize(cfg_.decode_threads);
+        evt_waits_.resize(cfg_.decode_threads);
+        last_drain_ns_.store(mono_ns(), std::memory_order_relaxed);
+        drain_batch_.resize(kDrainBatch);
+        if (cfg_.work_stealing) {
+            lane_mu_.resize(cfg_.decode_threads);
+            for (auto& mu : lane_mu_) mu = std::make_unique<std::mutex>();
+            lane_order_.resize(cfg_.decode_threads);
+            for (auto& order : lane_order_) order = std::make_unique<LaneOrder>();
+        }
+
+        if (cfg_.shared_nothing) {
+            // all queues exist before any shard thread (or rebalance) looks at them
+            for (std::size_t i = 0; i < cfg_.decode_threads; ++i)
+                shard_qs_.push_back(rd_kafka_queue_new(rk_));
+        }
+
+        wall_minus_mono_ns_ =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count() - mono_ns();
+
+        if (cfg_.latency_stats) {
+            for (std::size_t i = 0; i < cfg_.decode_threads; ++i)
+                lat_workers_.push_back(std::make_unique<LatencyRecorder>());
+        }
+
+        if (cfg_.decoder_stats) {
+            for (std::size_t i = 0; i < cfg_.decode_threads; ++i)
+                cost_workers_.push_back(std::make_unique<DecodeCostRecorder>());
+        }
+
+        if (cfg_.flight_recorder > 0) {
+            for (std::size_t i = 0; i < cfg_.decode_threads; ++i)
+                // a whole decode batch is begun before any of it finishes
+                flight_.push_back(std::make_unique<FlightRecorder>(
+                    std::max(cfg_.flight_recorder, kDecodeBatch), static_cast<std::uint8_t>(i)));
+        }
+
+        dispatch_stage_.resize(cfg_.decode_threads);
+        for (auto& stage : dispatch_stage_)
+            stage.reserve(std::max<std::size_t>(1, cfg_.consume_batch));
 
         for (std::size_t i = 0; i < cfg_.decode_threads; ++i) {
+            const auto mem = lane_mem(i);
+
+            arenas_.push_back(std::make_unique<ArenaPool>());
+
             raw_qs_[i] = std::make_unique<
-                detail::SPSCRing<std::unique_ptr<RawMsg>>>(
-                cfg_.raw_queue_size);
+                detail::SPSCRing<RawMsg>>(
+                cfg_.raw_queue_size, mem);
 
             evt_qs_[i] = std::make_unique<
                 detail::SPSCRing<std::unique_ptr<Event>>>(
-                cfg_.evt_queue_size);
+                cfg_.evt_queue_size, mem);
+
+            free_qs_[i] = std::make_unique<
+                detail::SPSCRing<std::unique_ptr<Event>>>(
+                cfg_.evt_queue_size, mem);
 
             raw_epochs_[i] =
-                std::make_unique<std::atomic<uint64_t>>(0);
+                std::make_unique<detail::WaitPoint>(cfg_.wait_strategy, cfg_.spin_iterations);
+
+            /* drainTo signals once per lane per drain; never pay a futex
+             * wake unless the worker is really parked */
+            evt_waits_[i] = cfg_.wait_strategy == WaitStrategy::BusyPoll
+                ? std::make_unique<detail::WaitPoint>(WaitStrategy::BusyPoll, 0)
+                : std::make_unique<detail::WaitPoint>(
+                      WaitStrategy::SpinThenPark,
+                      cfg_.wait_strategy == WaitStrategy::Blocking ? 0 : cfg_.spin_iterations);
+        }
 
+        // every lane exists before any worker (or thief) looks at its neighbours
+        for (std::size_t i = 0; i < cfg_.decode_threads; ++i) {
             workers_.emplace_back(
-                &Core::decode_loop,
+                cfg_.shared_nothing ? &Core::shard_loop : &Core::decode_loop,
                 this,
                 i);
         }
@@ -262,8 +547,10 @@ namespace kafkax {
         stop_.store(true, std::memory_order_release);
 
         for (auto& e : raw_epochs_) {
-            e->fetch_add(1);
-            std::atomic_notify_all(e.get());
+            e->close();
+        }
+        for (auto& e : evt_waits_) {
+            e->close();
         }
 
         if (consumer_th_.joinable())
@@ -273,8 +560,24 @@ namespace kafkax {
             if (w.joinable())
                 w.join();
 
+        /* zero-copy Events and undecoded RawMsgs hold rdkafka messages: they
+         * must be gone before the consumer is closed and destroyed */
+        release_queued();
+
+        if (rk_ && ack_commit_) {
+            commit_acked(false);
+        }
+
+        if (source_ && source_->is_kafka()) {
+            source_.reset();   // holds a consumer queue reference
+        }
+
         if (rk_) {
             rd_kafka_consumer_close(rk_);
+
+            for (auto* q : shard_qs_) rd_kafka_queue_destroy(q);
+            shard_qs_.clear();
+
             rd_kafka_destroy(rk_);
         }
 
@@ -289,61 +592,211 @@ namespace kafkax {
         }
     }
 
+    void Core::release_queued()
+    {
+        for (auto& stage : dispatch_stage_)
+            stage.clear();
+
+        RawMsg raw;
+        for (auto& q : raw_qs_)
+            while (q->try_pop(raw))
+                raw.reset();
+
+        std::unique_ptr<Event> ev;
+        for (auto& q : evt_qs_)
+            while (q->try_pop(ev))
+                ev.reset();
+        for (auto& q : free_qs_)
+            while (q->try_pop(ev))
+                ev.reset();
+        drain_shells_.clear();
+
+        total_evt_.store(0, std::memory_order_relaxed);
+    }
+
     /* ============================================================
      * ======================  Consumer Loop ======================
      * ============================================================ */
     void Core::consumer_loop() {
 
+        placement::name_current_thread("kfkx-consumer");
+        (void)placement::pin_current_thread(consumer_cpus_);
+
+        /* a Kafka source polls one message at a time unless consume_batch is
+         * set; the others are only ever bounded by the rings */
+        const std::size_t per_poll = cfg_.consume_batch > 1 ? cfg_.consume_batch
+            : source_->is_kafka() ? 1 : kDecodeBatch;
+        std::vector<rd_kafka_message_t*> batch(
+            std::max<std::size_t>({per_poll, cfg_.catchup_batch}));
+
         while (!stop_.load(std::memory_order_acquire)) {
 
+            if (seek_pending_.exchange(false, std::memory_order_acq_rel))
+                apply_pending_seeks();
+
             /* Resume requested */
             if (paused_.load(std::memory_order_acquire) &&
                 resume_requested_.exchange(false))
             {
                 std::lock_guard<std::mutex> lk(assign_mu_);
                 if (assignment_) {
-                    rd_kafka_resume_partitions(rk_, assignment_);
+                    // leave partitions that are paused on their own alone
+                    auto* list = unpaused_assignment();
+                    rd_kafka_resume_partitions(rk_, list ? list : assignment_);
+                    KAFKAX_PROBE(resume, list ? assignment_->cnt - list->cnt : 0);
+                    if (list) rd_kafka_topic_partition_list_destroy(list);
                     paused_.store(false, std::memory_order_release);
                 }
             }
 
-            auto* msg = rd_kafka_consumer_poll(rk_, 100);
+            if (part_resume_requested_.exchange(false, std::memory_order_acq_rel))
+                resume_cool_partitions();
+
+            /* everything it produced has been through dispatch by now */
+            if (!source_done_.load(std::memory_order_relaxed) && source_->done())
+                source_done_.store(true, std::memory_order_release);
+
+            std::size_t n = 0;
+            if (catchup_) {
+                n = source_->poll(std::span(batch.data(), cfg_.catchup_batch), cfg_.consume_timeout_ms);
+
+                /* a short batch means the local fetch queue ran dry: check the lag */
+                if (n < cfg_.catchup_batch && caught_up()) {
+                    rd_kafka_topic_partition_list_destroy(catchup_);
+                    catchup_ = nullptr;
+                }
+            } else {
+                n = source_->poll(std::span(batch.data(), per_poll), cfg_.consume_timeout_ms);
+            }
+
+            if (n == 0) {
+                if (ack_commit_) commit_acked(true);   // idle: flush what is pending
+                if (cfg_.shared_nothing) maybe_pause(); // shard threads never come through dispatch
+                continue;
+            }
+
+            KAFKAX_PROBE(poll, n);
+
+            dispatch(batch.data(), n);
+
+            if (cfg_.partition_high_watermark > 0)
+                pause_hot_partitions();
+            part_touched_.clear();
+
+            maybe_pause();
+
+            if (ack_commit_) {
+                auto now = mono_ns();
+                if (now - last_commit_ns_ >= static_cast<std::int64_t>(commit_interval_ms_) * 1000000) {
+                    commit_acked(true);
+                    last_commit_ns_ = now;
+                }
+            }
+        }
 
-            if (!msg) continue;
+        if (catchup_) {
+            rd_kafka_topic_partition_list_destroy(catchup_);
+            catchup_ = nullptr;
+        }
+    }
 
-            if (msg->err) {
-                rd_kafka_message_destroy(msg);
+    /* Route msgs[0..n) to the raw rings. Wakeups and the watermark counter are
+     * updated once per worker per call rather than once per message. */
+    std::size_t Core::dispatch(rd_kafka_message_t** msgs, std::size_t n)
+    {
+        std::size_t valid = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (msgs[i]->err) {
+                if (msgs[i]->err != RD_KAFKA_RESP_ERR__PARTITION_EOF) {
+                    kafka_errors_.fetch_add(1, std::memory_order_relaxed);
+                    note_error(rd_kafka_message_errstr(msgs[i]));
+                }
+                release_message(msgs[i]);
+                msgs[i] = nullptr;
                 continue;
             }
+            ++valid;
+        }
+        if (valid == 0) return 0;
+
+        /* account up front so decode-side fetch_sub never runs ahead */
+        total_raw_.fetch_add(valid, std::memory_order_relaxed);
+        consumed_.fetch_add(valid, std::memory_order_relaxed);
+
+        const bool per_partition = cfg_.partition_high_watermark > 0 || ack_commit_;
+        const auto gen = seek_gen_.load(std::memory_order_relaxed);   // only this thread bumps it
+        const auto polled = cfg_.latency_stats ? mono_ns() : 0;
+
+        /* stage per worker so each ring sees one bulk push per batch */
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!msgs[i]) continue;
+
+            PartitionState* part = nullptr;
+            if (per_partition) {
+                part = partition_state(msgs[i]);
+                if (part->batch_count++ == 0) part_touched_.push_back(part);
+                if (ack_commit_) part->ack_stage.push_back(msgs[i]->offset);
+            }
+
+            auto worker = next_worker(msgs[i]);
+            dispatch_stage_[worker].emplace_back(msgs[i], part, gen, polled);
+        }
+
+        /* one depth update (and ack window append) per partition per batch,
+         * before workers / drain can see the messages */
+        for (auto* part : part_touched_) {
+            if (cfg_.partition_high_watermark > 0)
+                part->depth.fetch_add(part->batch_count, std::memory_order_relaxed);
+            part->batch_count = 0;
+
+            if (!part->ack_stage.empty()) {
+                std::lock_guard<std::mutex> lk(part->ack_mu);
+                for (auto off : part->ack_stage) part->ack_window.emplace_back(off, false);
+                part->ack_stage.clear();
+            }
+        }
 
-            auto raw = std::make_unique<RawMsg>();
-            raw->msg = msg;
+        std::size_t pushed = 0;
+        for (std::size_t w = 0; w < dispatch_stage_.size(); ++w) {
+            auto& stage = dispatch_stage_[w];
+            if (stage.empty()) continue;
 
-            auto worker = next_worker(raw->msg);
+            auto& epoch = *raw_epochs_[w];
+            std::size_t done = 0;
 
             /* Backpressure push (blocking) */
             for (;;) {
-                auto tmp = std::move(raw);
-                if (raw_qs_[worker]->try_push(std::move(tmp))) break;
-                raw = std::move(tmp);  // push failed , retrieve msg
+                done += raw_qs_[w]->try_push_n(std::span<RawMsg>(stage).subspan(done));
+                if (done == stage.size()) break;
 
+                /* let the worker start on what it already has before sleeping */
+                epoch.signal();
                 maybe_pause();
 
-                auto& epoch = *raw_epochs_[worker];
-                auto seen = epoch.load();
-                std::atomic_wait(&epoch, seen);
+                /* snapshot, then re-check, so a pop in between is not missed */
+                auto seen = epoch.prepare();
+                done += raw_qs_[w]->try_push_n(std::span<RawMsg>(stage).subspan(done));
+                if (done == stage.size()) break;
+
+                KAFKAX_PROBE(push_blocked, w, stage.size() - done);
+                epoch.wait(seen);
 
                 if (stop_.load()) break;
             }
 
-            auto& epoch = *raw_epochs_[worker];
-            epoch.fetch_add(1);
-            std::atomic_notify_one(&epoch);
+            pushed += done;
+            stage.clear();   // anything not pushed (stopping) is released here
 
-            total_raw_.fetch_add(1);
+            epoch.signal();
 
-            maybe_pause();
+            if (cfg_.work_stealing && raw_qs_[w]->size() >= cfg_.steal_threshold)
+                wake_thief(w);
         }
+
+        if (pushed < valid)
+            total_raw_.fetch_sub(valid - pushed, std::memory_order_relaxed);
+
+        return pushed;
     }
 
     /* ============================================================
@@ -351,227 +804,1469 @@ namespace kafkax {
      * ============================================================ */
     void Core::decode_loop(std::size_t id)
     {
-        auto& rq = *raw_qs_[id];
-        auto& eq = *evt_qs_[id];
         auto& epoch = *raw_epochs_[id];
+        const bool stealing = cfg_.work_stealing && cfg_.decode_threads > 1;
 
-        while (!stop_.load(std::memory_order_acquire)) {
+        placement::name_current_thread("kfkx-decode-" + std::to_string(id));
+        pin_decoder(id);   // before the scratch and event pool are first touched
 
-            std::unique_ptr<RawMsg> raw;
+        DecodeScratch scratch;
+        init_scratch(scratch);
 
-            if (!rq.try_pop(raw)) {
-                auto seen = epoch.load();
-                std::atomic_wait(&epoch, seen);
-                continue;
-            }
+        while (!stop_.load(std::memory_order_acquire)) {
 
-            epoch.fetch_add(1);
-            std::atomic_notify_one(&epoch);
+            auto seen = epoch.prepare();
 
-            total_raw_.fetch_sub(1, std::memory_order_relaxed);
+            if (decode_batch(id, id, scratch) > 0) continue;
 
-            /* If below low watermark → request resume */
-            if (paused_.load(std::memory_order_acquire) &&
-                total_raw_.load(std::memory_order_relaxed) <= low_watermark_)
-            {
-                resume_requested_.store(true, std::memory_order_release);
-            }
+            if (stealing && try_steal(id, scratch)) continue;
 
-            auto ev = std::make_unique<Event>();
+            epoch.wait(seen);
+        }
+    }
 
-            const auto* msg = raw->msg;
+    /* Shared-nothing worker: consume the partitions forwarded to this thread and
+     * decode in place. The raw ring is still checked so a message that reached
+     * the consumer queue before forwarding took effect is not stranded. */
+    void Core::shard_loop(std::size_t id)
+    {
+        auto* q = shard_qs_[id];
 
-            if (!msg) {
-                ev->kind = Event::Kind::Error;
-                std::strncpy(
-                    ev->err_msg,
-                    "null kafka message",
-                    sizeof(ev->err_msg));
-            } else {
-                ev->topic = rd_kafka_topic_name(msg->rkt);
+        placement::name_current_thread("kfkx-shard-" + std::to_string(id));
+        pin_decoder(id);
 
-                if (msg->key && msg->key_len > 0) {
-                    const auto* key = static_cast<const std::uint8_t*>(msg->key);
-                    ev->key.assign(key, key + msg->key_len);
-                }
+        DecodeScratch scratch;
+        init_scratch(scratch);
 
-                rd_kafka_timestamp_type_t ts_type = RD_KAFKA_TIMESTAMP_NOT_AVAILABLE;
-                const std::int64_t ts_ms = rd_kafka_message_timestamp(msg, &ts_type);
-                if (ts_ms >= 0) {
-                    ev->ingest_ns = ts_ms * 1000000;
-                }
-            }
+        std::vector<rd_kafka_message_t*> msgs(kDecodeBatch);
 
-            auto fn = registry_.get_fn(ev->topic);
+        while (!stop_.load(std::memory_order_acquire)) {
 
-            if (ev->kind == Event::Kind::Error) {
-                // keep existing error
-            } else if (!fn) {
-                ev->kind = Event::Kind::Error;
-                std::strncpy(
-                    ev->err_msg,
-                    "decoder not bound",
-                    sizeof(ev->err_msg));
-            } else {
-                kafkax_decode_out_t out{};
-
-                kafkax_envelope_t env{};
-                env.topic = kafkax_str_view_t{ev->topic.data(), ev->topic.size()};
-                env.partition = msg->partition;
-                env.offset = msg->offset;
-
-                rd_kafka_timestamp_type_t ts_type = RD_KAFKA_TIMESTAMP_NOT_AVAILABLE;
-                env.timestamp_ms = rd_kafka_message_timestamp(msg, &ts_type);
-
-                env.key = kafkax_bytes_view_t{
-                    static_cast<const std::uint8_t*>(msg->key),
-                    static_cast<std::size_t>(msg->key_len)};
-                env.payload = kafkax_bytes_view_t{
-                    static_cast<const std::uint8_t*>(msg->payload),
-                    static_cast<std::size_t>(msg->len)};
-                env.symbol = kafkax_str_view_t{nullptr, 0};
-                env.opaque = msg;
-
-                ev->bytes.resize(4096);
-                out.buf = ev->bytes.data();
-                out.cap = ev->bytes.size();
-
-                int rc = fn(&env, &out);
-                if (rc == 0 && out.kind == KAFKAX_DECODE_NEED_MORE && out.need > out.cap) {
-                    ev->bytes.resize(out.need);
-                    out.buf = ev->bytes.data();
-                    out.cap = ev->bytes.size();
-                    rc = fn(&env, &out);
-                }
+            if (decode_batch(id, id, scratch) > 0) continue;
 
-                if (rc != 0 || out.kind != KAFKAX_DECODE_OK) {
-                    ev->kind = Event::Kind::Error;
-                    if (out.err_msg[0] != '\0') {
-                        std::strncpy(ev->err_msg, out.err_msg, sizeof(ev->err_msg));
-                    } else {
-                        std::strncpy(ev->err_msg, "decode failed", sizeof(ev->err_msg));
-                    }
-                    ev->err_msg[sizeof(ev->err_msg) - 1] = '\0';
-                } else {
-                    ev->kind = Event::Kind::Data;
-                    ev->bytes.resize(out.len);
-                }
-            }
+            auto r = rd_kafka_consume_batch_queue(
+                q, cfg_.consume_timeout_ms, msgs.data(), msgs.size());
+            if (r <= 0) continue;
 
-            if (msg) {
-                rd_kafka_message_destroy(raw->msg);
-                raw->msg = nullptr;
-            }
+            KAFKAX_PROBE(poll, r);
 
-            /* Blocking event push */
-            for (;;) {
-                auto tmp = std::move(ev);
-                if (eq.try_push(std::move(tmp))) break;
-                ev = std::move(tmp);   // push failed, retrieve
+            /* read after consuming: a message racing a seek is delivered, never lost */
+            const auto gen = seek_gen_.load(std::memory_order_acquire);
+            const auto polled = cfg_.latency_stats ? mono_ns() : 0;
 
-                std::this_thread::yield();
-                if (stop_.load()) break;
+            std::size_t n = 0;
+            for (ssize_t i = 0; i < r; ++i) {
+                if (msgs[i]->err) {
+                    if (msgs[i]->err != RD_KAFKA_RESP_ERR__PARTITION_EOF) {
+                        kafka_errors_.fetch_add(1, std::memory_order_relaxed);
+                        note_error(rd_kafka_message_errstr(msgs[i]));
+                    }
+                    rd_kafka_message_destroy(msgs[i]);
+                    continue;
+                }
+                scratch.raws[n++] = RawMsg(msgs[i], nullptr, gen, polled);
             }
-
-            bool expected = false;
-            if (evt_notified_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
-                uint64_t one = 1;
-                (void)::write(efd_, &one, sizeof(one));
+            if (n > 0) {
+                consumed_.fetch_add(n, std::memory_order_relaxed);
+                decode_raws(id, id, scratch, n);
             }
         }
     }
 
-    void Core::maybe_pause() {
-        if (paused_.load(std::memory_order_acquire))
-            return;
-
-        if (total_raw_.load(std::memory_order_relaxed) < high_watermark_)
-            return;
-
-        std::lock_guard<std::mutex> lk(assign_mu_);
+    /* consumer thread (rebalance): spread parts over the shard queues, or detach them */
+    void Core::forward_partitions(const rd_kafka_topic_partition_list_t* parts, bool attach)
+    {
+        if (!parts || shard_qs_.empty()) return;
 
-        if (!assignment_)
-            return;
+        for (int i = 0; i < parts->cnt; ++i) {
+            const auto& tp = parts->elems[i];
+            auto* pq = rd_kafka_queue_get_partition(rk_, tp.topic, tp.partition);
+            if (!pq) continue;
 
-        rd_kafka_pause_partitions(rk_, assignment_);
-        paused_.store(true, std::memory_order_release);
+            rd_kafka_queue_forward(pq, attach ? shard_qs_[(std::size_t)i % shard_qs_.size()] : nullptr);
+            rd_kafka_queue_destroy(pq);
+        }
     }
 
-    /* ============================================================
-     * ======================  Control Plane ======================
-     * ============================================================ */
+    void Core::pin_decoder(std::size_t id) const
+    {
+        if (decoder_cpus_.empty()) return;
+        (void)placement::pin_current_thread({decoder_cpus_[id % decoder_cpus_.size()]});
+    }
 
-    int Core::bind_topic(const std::string& topic,
-                     const std::string& so_path,
-                     const std::string& symbol,
-                     std::string& err)
+    /* rings of a lane live with the decoder that owns the lane */
+    placement::MemPolicy Core::lane_mem(std::size_t lane) const
     {
-        return registry_.bind(topic, so_path, symbol, err);
+        placement::MemPolicy mem;
+        mem.huge = cfg_.huge_pages;
+        if (cfg_.numa_local && !decoder_cpus_.empty())
+            mem.node = placement::cpu_node(decoder_cpus_[lane % decoder_cpus_.size()]);
+        return mem;
     }
 
-    int Core::rebind_topic(const std::string& topic,
-                           const std::string& so_path,
-                           const std::string& symbol,
-                           std::string& err)
+    void Core::init_scratch(DecodeScratch& scratch)
     {
-        return registry_.rebind(topic, so_path, symbol, err);
+        scratch.raws.resize(kDecodeBatch);
+        scratch.evs.resize(kDecodeBatch);
+        scratch.names.resize(kDecodeBatch);
+        scratch.lat_topics.resize(kDecodeBatch);
+        scratch.flight_pos.resize(kDecodeBatch);
+        scratch.envs.reserve(kDecodeBatch);
+        scratch.results.reserve(kDecodeBatch);
     }
 
-    int Core::unbind_topic(const std::string& topic)
+    /* Pop one batch from lane's raw ring, decode it with self's pool/scratch and
+     * push the events to lane's event ring. With work stealing the pop is taken
+     * under lane_mu_[lane] together with a ticket; decode_raws publishes in
+     * ticket order, so the owner and thieves decode the lane concurrently. */
+    std::size_t Core::decode_batch(std::size_t lane, std::size_t self, DecodeScratch& scratch)
     {
-        return registry_.unbind(topic);
+        auto& rq = *raw_qs_[lane];
+        auto& epoch = *raw_epochs_[lane];
+
+        auto& raws = scratch.raws;
+
+        std::size_t n = 0;
+        std::uint64_t ticket = kNoTicket;
+        if (!lane_mu_.empty()) {
+            std::lock_guard<std::mutex> lk(*lane_mu_[lane]);
+            n = rq.try_pop_n(std::span<RawMsg>(raws));
+            if (n > 0) ticket = lane_order_[lane]->popped++;
+        } else {
+            n = rq.try_pop_n(std::span<RawMsg>(raws));
+        }
+        if (n == 0) return 0;
+
+        epoch.signal();
+
+        total_raw_.fetch_sub(n, std::memory_order_relaxed);
+
+        if (cfg_.partition_high_watermark > 0)
+            release_partition_depth(raws.data(), n);
+
+        decode_raws(lane, self, scratch, n, ticket);
+        return n;
     }
 
-    bool Core::get_topic_decoder(const std::string& topic,
-                                 DecoderRegistry::BindingInfo& out) const
+    /* Work stealing: wait until every earlier batch of lane has been pushed.
+     * Those are being decoded or pushed by other threads right now, so this
+     * spins, then yields. false when stopping (the batch must not be pushed). */
+    bool Core::wait_publish_turn(std::size_t lane, std::uint64_t ticket) const noexcept
     {
-        return registry_.get_decoder_info(topic, out);
+        const auto& order = *lane_order_[lane];
+        for (std::uint32_t spins = 0; order.published.load(std::memory_order_acquire) != ticket; ++spins) {
+            if (stop_.load(std::memory_order_relaxed)) return false;
+            if (spins < cfg_.spin_iterations) detail::cpu_relax();
+            else std::this_thread::yield();
+        }
+        return true;
     }
 
-    /* ============================================================
-     * ======================  Drain ==============================
-     * ============================================================ */
+    /* Decode scratch.raws[0..n) and push the events to lane's event ring. */
+    void Core::decode_raws(std::size_t lane, std::size_t self, DecodeScratch& scratch, std::size_t n,
+                           std::uint64_t ticket)
+    {
+        auto& eq = *evt_qs_[lane];
+        auto& fq = *free_qs_[self];
 
-    void Core::drainTo(std::vector<Event>& out, std::size_t limit) {
+        auto& raws = scratch.raws;
+        auto& evs = scratch.evs;
+        auto& names = scratch.names;
 
-        if (evt_qs_.empty())
-            return;
+        refresh_router(scratch);
 
-        auto qn = evt_qs_.size();
-        auto start = drain_rr_.fetch_add(1) % qn;
+        auto* flight = flight_.empty() ? nullptr : flight_[self].get();
+        const bool timed = cfg_.latency_stats || flight;
+        const auto t_start = timed ? mono_ns() : 0;
 
-        for (std::size_t i = 0; i < qn; ++i)
+        /* If below low watermark → request resume */
+        if (paused_.load(std::memory_order_acquire) && below_low_watermarks())
         {
-            auto idx = (start + i) % qn;
+            resume_requested_.store(true, std::memory_order_release);
+        }
+
+        for (std::size_t i = 0; i < n; ++i) {
+            auto& ev = evs[i];
+            if (!ev && fq.try_pop(ev)) {
+                /* recycled: reset fields, keep buffer capacity */
+                ev->kind = Event::Kind::Data;
+                ev->topic_id = TopicTable::kInvalid;
+                ev->partition = -1;
+                ev->offset = -1;
+                ev->seek_gen = 0;
+                ev->key.clear();
+                ev->ingest_ns = 0;
+                ev->poll_ns = 0;
+                ev->ready_ns = 0;
+                ev->decoder.clear();
+                ev->err_msg[0] = '\0';
+                ev->release_msg();
+            } else if (!ev) {
+                ev = std::make_unique<Event>();
+            }
+            ev->worker = static_cast<std::uint32_t>(self);
+            ev->seek_gen = raws[i].gen;
+            ev->poll_ns = raws[i].poll_ns;
 
-            std::unique_ptr<Event> ev;
+            names[i] = prepare_event(raws[i].msg, *ev, scratch);
 
-            while (out.size() < limit && evt_qs_[idx]->try_pop(ev)) {
-                out.push_back(std::move(*ev));
+            /* the input side now: decode releases the message */
+            if (flight && raws[i].msg) {
+                const auto* msg = raws[i].msg;
+                scratch.flight_pos[i] = flight->begin(ev->topic_id, msg->partition, msg->offset,
+                                                      msg->payload, msg->len);
             }
-            if (out.size() >= limit) break;
         }
 
-        // check whether any evt_q still has data
-        bool any_left = false;
-        for (auto& q : evt_qs_) {
-            if (q && q->size() > 0) { any_left = true; break; }
+        for (std::size_t i = 0; i < n;) {
+            const auto* msg = raws[i].msg;
+            static const Route no_route{};
+            const auto& route = names[i]
+                ? route_for(scratch, evs[i]->topic_id, *names[i])
+                : no_route;
+
+            if (route.batch_fn) {
+                /* prefer the batch entrypoint for a run of same-topic messages */
+                std::size_t j = i + 1;
+                while (j < n && raws[j].msg && raws[j].msg->rkt == msg->rkt) ++j;
+
+                decode_run(self, &raws[i], &evs[i], &names[i], j - i, route.batch_fn, scratch,
+                           cost_slot(self, scratch, evs[i]->topic_id, route));
+                i = j;
+            } else {
+                static const std::string no_topic;
+                decode_message(raws[i], *evs[i], route.fn, names[i] ? *names[i] : no_topic,
+                               names[i] ? cost_slot(self, scratch, evs[i]->topic_id, route) : nullptr);
+                ++i;
+            }
         }
 
-        if (!any_left) {
-            // all empty -> allow next notify from decode threads
-            evt_notified_.store(false, std::memory_order_release);
-        } else {
-            // still has data -> make eventfd readable again for next sd1 tick
+        std::size_t errors = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            errors += evs[i]->kind == Event::Kind::Error;
+        if (errors > 0) decode_errors_.fetch_add(errors, std::memory_order_relaxed);
+
+        /* everything but Publish is recorded while this thread still owns the events */
+        const auto t_end = timed ? mono_ns() : 0;
+        const auto per_msg = timed ? (t_end - t_start) / static_cast<std::int64_t>(n) : 0;
+
+        if (flight) {
+            const auto wall = t_end + wall_minus_mono_ns_;
+            for (std::size_t i = 0; i < n; ++i) {
+                if (!names[i]) continue;   // null message: nothing was begun
+                const auto& ev = *evs[i];
+                flight->finish(scratch.flight_pos[i], wall, static_cast<std::uint32_t>(per_msg),
+                               ev.kind != Event::Kind::Error, ev.err_msg);
+            }
+        }
+
+        if (cfg_.latency_stats) {
+            auto& rec = *lat_workers_[self];
+
+            for (std::size_t i = 0; i < n; ++i) {
+                auto& ev = *evs[i];
+                ev.ready_ns = t_end;
+                scratch.lat_topics[i] = ev.topic_id;
+                if (ev.topic_id == TopicTable::kInvalid) continue;
+
+                auto& st = rec.topic(ev.topic_id);
+                if (ev.ingest_ns > 0)
+                    st[(std::size_t)LatencyStage::Broker].record(ev.poll_ns + wall_minus_mono_ns_ - ev.ingest_ns);
+                st[(std::size_t)LatencyStage::Queue].record(t_start - ev.poll_ns);
+                st[(std::size_t)LatencyStage::Decode].record(per_msg);
+            }
+        }
+
+        /* account up front so drain-side fetch_sub never runs ahead */
+        total_evt_.fetch_add(n, std::memory_order_relaxed);
+
+        /* Blocking event push: park until drainTo makes room (q may be slow) */
+        auto& ew = *evt_waits_[lane];
+        auto pending = std::span<std::unique_ptr<Event>>(evs.data(), n);
+        std::size_t done = 0;
+        const bool my_turn = ticket == kNoTicket || wait_publish_turn(lane, ticket);
+        for (; my_turn;) {
+            done += eq.try_push_n(pending.subspan(done));
+            if (done == n) break;
+
+            auto seen = ew.prepare();
+            done += eq.try_push_n(pending.subspan(done));
+            if (done == n) break;
+
+            KAFKAX_PROBE(evt_blocked, lane, n - done);
+            ew.wait(seen);
+            if (stop_.load()) break;
+        }
+
+        if (ticket != kNoTicket)
+            lane_order_[lane]->published.store(ticket + 1, std::memory_order_release);
+
+        if (done < n)
+            total_evt_.fetch_sub(n - done, std::memory_order_relaxed);
+
+        if (cfg_.latency_stats) {
+            const auto waited = mono_ns() - t_end;
+            auto& rec = *lat_workers_[self];
+            for (std::size_t i = 0; i < n;) {
+                const auto tid = scratch.lat_topics[i];
+                std::size_t j = i + 1;
+                while (j < n && scratch.lat_topics[j] == tid) ++j;
+                if (tid != TopicTable::kInvalid)
+                    rec.topic(tid)[(std::size_t)LatencyStage::Publish].record(waited, j - i);
+                i = j;
+            }
+        }
+
+        bool expected = false;
+        if (evt_notified_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            uint64_t one = 1;
+            (void)::write(efd_, &one, sizeof(one));
+        }
+    }
+
+    /* Idle worker: take one batch from the first lane that is backed up and
+     * decode it next to whoever else is working that lane. */
+    bool Core::try_steal(std::size_t self, DecodeScratch& scratch)
+    {
+        const auto nw = raw_qs_.size();
+        for (std::size_t k = 1; k < nw; ++k) {
+            auto victim = (self + k) % nw;
+            if (raw_qs_[victim]->size() < cfg_.steal_threshold) continue;
+
+            if (decode_batch(victim, self, scratch) > 0) {
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* Consumer side: lane is backed up, wake one worker that has nothing to do. */
+    void Core::wake_thief(std::size_t lane)
+    {
+        const auto nw = raw_qs_.size();
+        for (std::size_t k = 1; k < nw; ++k) {
+            auto v = (lane + k) % nw;
+            if (raw_qs_[v]->size() != 0) continue;
+
+            raw_epochs_[v]->signal();
+            return;
+        }
+    }
+
+    namespace {
+        inline void set_error(Event& ev, const char* what) {
+            ev.kind = Event::Kind::Error;
+            std::strncpy(ev.err_msg, what, sizeof(ev.err_msg));
+            ev.err_msg[sizeof(ev.err_msg) - 1] = '\0';
+        }
+
+        inline void copy_key(const rd_kafka_message_t* msg, Event& ev) {
+            if (msg->key && msg->key_len > 0) {
+                const auto* key = static_cast<const std::uint8_t*>(msg->key);
+                ev.key.assign(key, key + msg->key_len);
+            }
+        }
+
+        inline kafkax_envelope_t make_envelope(const rd_kafka_message_t* msg, const std::string& topic) {
+            kafkax_envelope_t env{};
+            env.topic = kafkax_str_view_t{topic.data(), topic.size()};
+            env.partition = msg->partition;
+            env.offset = msg->offset;
+
+            env.timestamp_ms = message_timestamp(msg);
+
+            env.key = kafkax_bytes_view_t{
+                static_cast<const std::uint8_t*>(msg->key),
+                static_cast<std::size_t>(msg->key_len)};
+            env.payload = kafkax_bytes_view_t{
+                static_cast<const std::uint8_t*>(msg->payload),
+                static_cast<std::size_t>(msg->len)};
+            env.symbol = kafkax_str_view_t{nullptr, 0};
+            env.opaque = msg;
+            return env;
+        }
+    } // namespace
+
+    void Core::refresh_router(DecodeScratch& scratch)
+    {
+        auto gen = registry_.generation();
+        if (gen == scratch.router_gen) return;
+
+        scratch.router = registry_.snapshot();
+        scratch.router_gen = gen;
+        std::fill(scratch.route_known.begin(), scratch.route_known.end(), 0);
+    }
+
+    const Route& Core::route_for(DecodeScratch& scratch,
+                                 std::uint32_t topic_id,
+                                 const std::string& topic)
+    {
+        if (topic_id >= scratch.routes.size()) {
+            scratch.routes.resize((std::size_t)topic_id + 1);
+            scratch.route_known.resize((std::size_t)topic_id + 1, 0);
+            scratch.costs.resize((std::size_t)topic_id + 1, nullptr);
+        }
+
+        if (!scratch.route_known[topic_id]) {
+            scratch.routes[topic_id] = scratch.router ? scratch.router->lookup_route(topic) : Route{};
+            scratch.costs[topic_id] = nullptr;   // binding may have changed
+            scratch.route_known[topic_id] = 1;
+        }
+        return scratch.routes[topic_id];
+    }
+
+    /* Only after route_for(topic_id): the slot is memoised alongside the route. */
+    DecodeCostRecorder::Slot* Core::cost_slot(std::size_t self,
+                                              DecodeScratch& scratch,
+                                              std::uint32_t topic_id,
+                                              const Route& route)
+    {
+        if (!cfg_.decoder_stats || !route.binding) return nullptr;
+
+        auto& slot = scratch.costs[topic_id];
+        if (!slot) slot = cost_workers_[self]->slot(topic_id, route.binding);
+        return slot;
+    }
+
+    const std::string* Core::prepare_event(const rd_kafka_message_t* msg,
+                                           Event& ev,
+                                           DecodeScratch& scratch)
+    {
+        if (!msg) {
+            set_error(ev, "null kafka message");
+            return nullptr;
+        }
+
+        ev.partition = msg->partition;
+        ev.offset = msg->offset;
+
+        const std::string* name = nullptr;
+        for (const auto& slot : scratch.topics) {
+            if (slot.rkt == msg->rkt) {
+                ev.topic_id = slot.id;
+                name = slot.name;
+                break;
+            }
+        }
+        if (!name) {
+            // first message of this topic on this worker
+            auto id = topics_.intern(message_topic(msg));
+            name = &topics_.name(id);
+            scratch.topics.push_back(DecodeScratch::TopicSlot{msg->rkt, id, name});
+            ev.topic_id = id;
+        }
+
+        const std::int64_t ts_ms = message_timestamp(msg);
+        if (ts_ms >= 0) {
+            ev.ingest_ns = ts_ms * 1000000;
+        }
+        return name;
+    }
+
+    void Core::decode_message(RawMsg& raw,
+                              Event& ev,
+                              kafkax_decode_fn fn,
+                              const std::string& topic,
+                              DecodeCostRecorder::Slot* cost)
+    {
+        const auto* msg = raw.msg;
+
+        /* built-in decoders are plain passthrough: nothing to decode */
+        const bool zero_copy = cfg_.zero_copy && msg &&
+            (fn == kafkax_passthrough_decoder || fn == kafkax_default_decoder);
+
+        if (msg && !zero_copy) {
+            copy_key(msg, ev);
+        }
+
+        if (ev.kind == Event::Kind::Error) {
+            // keep existing error
+        } else if (zero_copy) {
+            ev.kind = Event::Kind::Data;
+            ev.bytes.clear();
+            ev.payload_ref = std::span<const std::uint8_t>(
+                static_cast<const std::uint8_t*>(msg->payload), msg->len);
+            if (msg->key && msg->key_len > 0) {
+                ev.key_ref = std::span<const std::uint8_t>(
+                    static_cast<const std::uint8_t*>(msg->key), msg->key_len);
+            }
+
+            /* RawMsg ownership moves into the Event */
+            ev.msg.reset(std::exchange(raw.msg, nullptr));
+        } else if (!fn) {
+            set_error(ev, "decoder not bound");
+        } else {
+            /* only the fields the decoder reads; err_msg is not zero-filled */
+            kafkax_decode_out_t out;
+            out.kind = KAFKAX_DECODE_ERR;
+            out.len = 0;
+            out.need = 0;
+            out.err_msg[0] = '\0';
+
+            const auto env = make_envelope(msg, topic);
+
+            /* decode into whatever capacity a recycled buffer already has
+             * (ByteBuffer: growing the size does not touch the bytes) */
+            ev.bytes.resize(std::max<std::size_t>(4096, ev.bytes.capacity()));
+            out.buf = ev.bytes.data();
+            out.cap = ev.bytes.size();
+
+            KAFKAX_PROBE(decode_start, topic.c_str(), msg->partition, msg->offset);
+
+            const auto t0 = cost ? mono_ns() : 0;
+            bool retried = false;
+
+            int rc = fn(&env, &out);
+            if (rc == 0 && out.kind == KAFKAX_DECODE_NEED_MORE && out.need > out.cap) {
+                KAFKAX_PROBE(need_more, topic.c_str(), msg->offset, out.need);
+                ev.bytes.resize(out.need);
+                out.buf = ev.bytes.data();
+                out.cap = ev.bytes.size();
+                rc = fn(&env, &out);
+                retried = true;
+            }
+
+            const bool ok = rc == 0 && out.kind == KAFKAX_DECODE_OK;
+            if (cost) {
+                /* includes the resize between the two calls: that is what the retry costs */
+                cost->add(1, static_cast<std::uint64_t>(mono_ns() - t0), msg->len,
+                          ok ? out.len : 0, retried, !ok);
+            }
+
+            if (!ok) {
+                out.err_msg[sizeof(out.err_msg) - 1] = '\0';
+                set_error(ev, out.err_msg[0] != '\0' ? out.err_msg : "decode failed");
+                KAFKAX_PROBE(decode_error, topic.c_str(), msg->partition, msg->offset, ev.err_msg);
+            } else {
+                ev.kind = Event::Kind::Data;
+                ev.bytes.resize(out.len);
+            }
+
+            KAFKAX_PROBE(decode_end, topic.c_str(), msg->partition, msg->offset, ev.kind == Event::Kind::Data);
+        }
+
+        raw.reset();
+    }
+
+    ArenaBlock& Core::arena_room(ArenaPool& pool, std::size_t need)
+    {
+        auto& blocks = pool.blocks;
+        if (!blocks.empty() && blocks[pool.cur]->bytes.size() - pool.used >= need)
+            return *blocks[pool.cur];
+
+        /* oldest first: the block after the current one was filled longest ago */
+        for (std::size_t i = 1; i <= blocks.size(); ++i) {
+            const auto idx = (pool.cur + i) % blocks.size();
+            auto& block = *blocks[idx];
+            if (block.refs.load(std::memory_order_acquire) != 0) continue;
+
+            if (block.bytes.size() < need) block.bytes.resize(need);
+            pool.cur = idx;
+            pool.used = 0;
+            return block;
+        }
+
+        blocks.push_back(std::make_unique<ArenaBlock>());
+        blocks.back()->bytes.resize(std::max(kDecodeArena, need));
+        pool.cur = blocks.size() - 1;
+        pool.used = 0;
+        return *blocks.back();
+    }
+
+    /* Decode a same-topic run with the batch entrypoint. OK outputs are not
+     * copied: each event borrows its slice of the worker's arena block. */
+    void Core::decode_run(std::size_t self,
+                          RawMsg* raws,
+                          std::unique_ptr<Event>* evs,
+                          const std::string* const* names,
+                          std::size_t n,
+                          kafkax_decode_batch_fn batch_fn,
+                          DecodeScratch& scratch,
+                          DecodeCostRecorder::Slot* cost)
+    {
+        auto& envs = scratch.envs;
+        auto& results = scratch.results;
+        auto& pool = *arenas_[self];
+        std::size_t need = 1;   // at least some room in the block a call starts in
+
+        envs.resize(n);
+        results.resize(n);
+
+        for (std::size_t k = 0; k < n; ++k) {
+            copy_key(raws[k].msg, *evs[k]);
+            envs[k] = make_envelope(raws[k].msg, *names[k]);
+        }
+
+        std::size_t k = 0;
+        while (k < n) {
+            auto& block = arena_room(pool, need);
+
+            kafkax_decode_batch_out_t out;
+            out.arena = block.bytes.data() + pool.used;
+            out.cap = block.bytes.size() - pool.used;
+            out.used = 0;
+            out.results = results.data() + k;
+            out.count = 0;
+            out.err_msg[0] = '\0';
+
+            KAFKAX_PROBE(batch_start, names[k]->c_str(), n - k);
+            const auto t0 = cost ? mono_ns() : 0;
+            const int rc = batch_fn(envs.data() + k, n - k, &out);
+            const auto spent = cost ? static_cast<std::uint64_t>(mono_ns() - t0) : 0;
+            KAFKAX_PROBE(batch_end, names[k]->c_str(), n - k, out.count);
+
+            if (rc != 0 || out.count == 0 || out.count > n - k || out.used > out.cap) {
+                out.err_msg[sizeof(out.err_msg) - 1] = '\0';
+                const char* what = (rc != 0 && out.err_msg[0] != '\0') ? out.err_msg : "decode failed";
+                if (cost) {
+                    std::uint64_t in = 0;
+                    for (std::size_t e = k; e < n; ++e) in += raws[e].msg->len;
+                    cost->add(n - k, spent, in, 0, 0, n - k);
+                }
+                for (; k < n; ++k) {
+                    set_error(*evs[k], what);
+                    KAFKAX_PROBE(decode_error, names[k]->c_str(), raws[k].msg->partition, raws[k].msg->offset, what);
+                }
+                break;
+            }
+
+            std::size_t done = 0;
+            std::size_t borrowed = 0;
+            std::uint64_t in = 0, produced = 0, failed = 0;
+            need = 1;
+            for (; done < out.count; ++done) {
+                const auto& r = out.results[done];
+                auto& ev = *evs[k + done];
+
+                if (r.kind == KAFKAX_DECODE_NEED_MORE) {
+                    need = r.need;
+                    break;
+                }
+
+                in += raws[k + done].msg->len;
+                // only what the decoder says it wrote
+                if (r.kind == KAFKAX_DECODE_OK && r.offset <= out.used && r.len <= out.used - r.offset) {
+                    ev.kind = Event::Kind::Data;
+                    ev.bytes.clear();
+                    ev.payload_ref = std::span<const std::uint8_t>(out.arena + r.offset, r.len);
+                    ev.arena.reset(&block);
+                    ++borrowed;
+                    produced += r.len;
+                } else {
+                    set_error(ev, r.err ? r.err : "decode failed");
+                    ++failed;
+                    KAFKAX_PROBE(decode_error, names[k + done]->c_str(), raws[k + done].msg->partition,
+                                 raws[k + done].msg->offset, ev.err_msg);
+                }
+            }
+
+            /* one reference per borrowing event, taken before any is published;
+             * later calls append behind what this one used */
+            if (borrowed) block.refs.fetch_add(static_cast<std::uint32_t>(borrowed), std::memory_order_relaxed);
+            pool.used += out.used;
+
+            /* a call that stops at NEED_MORE is charged to the messages it finished;
+             * the envelope that asked for more counts one retry */
+            if (cost) cost->add(done, spent, in, produced, done < out.count, failed);
+            k += done;
+
+            if (done < out.count) {
+                KAFKAX_PROBE(need_more, names[k]->c_str(), raws[k].msg->offset, need);
+
+                /* NEED_MORE: retry from this envelope in a block with that much room;
+                 * asking for no more than it already had is a failure */
+                if (done == 0 && need <= out.cap) {
+                    set_error(*evs[k], "decode failed");
+                    if (cost) cost->add(1, 0, raws[k].msg->len, 0, 0, 1);
+                    ++k;
+                    need = 1;
+                }
+            }
+        }
+
+        for (std::size_t i = 0; i < n; ++i) {
+            raws[i].reset();
+        }
+    }
+
+    void Core::maybe_pause() {
+        if (paused_.load(std::memory_order_acquire))
+            return;
+
+        const auto evt = total_evt_.load(std::memory_order_relaxed);
+
+        /* raw rings filling, decoded events piling up, or q not draining at all */
+        if (total_raw_.load(std::memory_order_relaxed) < high_watermark_ &&
+            evt < evt_high_watermark_ &&
+            !(evt > 0 && drain_stalled()))
+            return;
+
+        std::lock_guard<std::mutex> lk(assign_mu_);
+
+        if (!assignment_)
+            return;
+
+        rd_kafka_pause_partitions(rk_, assignment_);
+        paused_.store(true, std::memory_order_release);
+        KAFKAX_PROBE(pause, total_raw_.load(std::memory_order_relaxed), evt);
+        pauses_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /* consumer thread: (rkt, partition) -> state, created on first message */
+    Core::PartitionState* Core::partition_state(const rd_kafka_message_t* msg)
+    {
+        std::vector<PartitionState*>* parts = nullptr;
+        for (auto& [rkt, vec] : part_index_) {
+            if (rkt == msg->rkt) { parts = &vec; break; }
+        }
+        if (!parts) {
+            part_index_.emplace_back(msg->rkt, std::vector<PartitionState*>{});
+            parts = &part_index_.back().second;
+        }
+
+        const auto p = static_cast<std::size_t>(std::max<std::int32_t>(0, msg->partition));
+        if (p >= parts->size()) parts->resize(p + 1, nullptr);
+
+        auto& slot = (*parts)[p];
+        if (!slot) {
+            auto st = std::make_unique<PartitionState>();
+            st->topic = message_topic(msg);
+            st->topic_id = topics_.intern(st->topic);
+            st->partition = msg->partition;
+            slot = st.get();
+
+            std::lock_guard<std::mutex> lk(part_mu_);
+            part_states_.push_back(std::move(st));
+        }
+        return slot;
+    }
+
+    /* consumer thread: pause just the partitions touched by the last batch that went over budget */
+    void Core::pause_hot_partitions()
+    {
+        rd_kafka_topic_partition_list_t* list = nullptr;
+
+        for (auto* part : part_touched_) {
+            if (part->paused) continue;
+            if (part->depth.load(std::memory_order_relaxed) < cfg_.partition_high_watermark) continue;
+
+            if (!list) list = rd_kafka_topic_partition_list_new(static_cast<int>(part_touched_.size()));
+            rd_kafka_topic_partition_list_add(list, part->topic.c_str(), part->partition);
+
+            part->resume_wanted.store(false, std::memory_order_relaxed);
+            part->paused = true;
+            part_pauses_.fetch_add(1, std::memory_order_relaxed);
+            KAFKAX_PROBE(partition_pause, part->topic.c_str(), part->partition,
+                         part->depth.load(std::memory_order_relaxed));
+        }
+
+        if (!list) return;
+
+        {
+            std::lock_guard<std::mutex> lk(assign_mu_);
+            rd_kafka_pause_partitions(rk_, list);
+        }
+        rd_kafka_topic_partition_list_destroy(list);
+    }
+
+    /* consumer thread: resume paused partitions whose backlog fell to the low watermark */
+    void Core::resume_cool_partitions()
+    {
+        rd_kafka_topic_partition_list_t* list = nullptr;
+
+        for (auto& part : part_states_) {
+            if (!part->paused) continue;
+            if (!part->resume_wanted.exchange(false, std::memory_order_acq_rel)) continue;
+
+            if (part->depth.load(std::memory_order_relaxed) > part_low_watermark_) continue;
+
+            if (!list) list = rd_kafka_topic_partition_list_new(4);
+            rd_kafka_topic_partition_list_add(list, part->topic.c_str(), part->partition);
+            part->paused = false;
+            KAFKAX_PROBE(partition_resume, part->topic.c_str(), part->partition,
+                         part->depth.load(std::memory_order_relaxed));
+        }
+
+        if (!list) return;
+
+        {
+            std::lock_guard<std::mutex> lk(assign_mu_);
+            // the global pause wins until it is lifted
+            if (!paused_.load(std::memory_order_acquire))
+                rd_kafka_resume_partitions(rk_, list);
+        }
+        rd_kafka_topic_partition_list_destroy(list);
+    }
+
+    /* decode worker: one fetch_sub per run of same-partition messages */
+    void Core::release_partition_depth(RawMsg* raws, std::size_t n)
+    {
+        std::size_t i = 0;
+        while (i < n) {
+            auto* part = raws[i].part;
+            std::size_t j = i + 1;
+            while (j < n && raws[j].part == part) ++j;
+
+            if (part) {
+                const auto run = j - i;
+                const auto prev = part->depth.fetch_sub(run, std::memory_order_relaxed);
+                if (prev > part_low_watermark_ && prev - run <= part_low_watermark_) {
+                    part->resume_wanted.store(true, std::memory_order_release);
+                    part_resume_requested_.store(true, std::memory_order_release);
+                }
+            }
+            i = j;
+        }
+    }
+
+    /* assignment_ minus individually paused partitions; nullptr when none are.
+     * Caller holds assign_mu_. */
+    rd_kafka_topic_partition_list_t* Core::unpaused_assignment() const
+    {
+        if (!assignment_) return nullptr;
+
+        bool any_paused = false;
+        for (auto& part : part_states_) {
+            if (part->paused) { any_paused = true; break; }
+        }
+        if (!any_paused) return nullptr;
+
+        auto* list = rd_kafka_topic_partition_list_new(assignment_->cnt);
+        for (int i = 0; i < assignment_->cnt; ++i) {
+            const auto& tp = assignment_->elems[i];
+
+            bool skip = false;
+            for (auto& part : part_states_) {
+                if (part->paused && part->partition == tp.partition && part->topic == tp.topic) {
+                    skip = true;
+                    break;
+                }
+            }
+            if (!skip) rd_kafka_topic_partition_list_add(list, tp.topic, tp.partition);
+        }
+        return list;
+    }
+
+    /* drain thread: mark drained offsets, advance each partition's commit point */
+    void Core::ack_drained(const Event* evs, std::size_t n)
+    {
+        std::size_t i = 0;
+        while (i < n) {
+            const auto tid = evs[i].topic_id;
+            const auto p = evs[i].partition;
+
+            std::size_t j = i + 1;
+            while (j < n && evs[j].topic_id == tid && evs[j].partition == p) ++j;
+
+            if (tid == TopicTable::kInvalid || p < 0) { i = j; continue; }
+
+            if (tid >= drain_parts_.size()) drain_parts_.resize((std::size_t)tid + 1);
+            auto& parts = drain_parts_[tid];
+            if ((std::size_t)p >= parts.size()) parts.resize((std::size_t)p + 1, nullptr);
+
+            auto*& part = parts[(std::size_t)p];
+            if (!part) {
+                std::lock_guard<std::mutex> lk(part_mu_);
+                for (auto& st : part_states_) {
+                    if (st->topic_id == tid && st->partition == p) { part = st.get(); break; }
+                }
+            }
+            if (!part) { i = j; continue; }
+
+            std::lock_guard<std::mutex> lk(part->ack_mu);
+            auto& win = part->ack_window;
+
+            for (std::size_t k = i; k < j; ++k) {
+                auto it = std::lower_bound(
+                    win.begin(), win.end(), evs[k].offset,
+                    [](const std::pair<std::int64_t, bool>& e, std::int64_t off) { return e.first < off; });
+                if (it != win.end() && it->first == evs[k].offset) it->second = true;
+            }
+
+            while (!win.empty() && win.front().second) {
+                part->ack_next = win.front().first + 1;
+                part->ack_dirty = true;
+                win.pop_front();
+            }
+
+            i = j;
+        }
+    }
+
+    /* consumer thread (or stop): commit every partition whose commit point moved */
+    void Core::commit_acked(bool async)
+    {
+        if (!rk_) return;
+
+        rd_kafka_topic_partition_list_t* list = nullptr;
+
+        {
+            std::lock_guard<std::mutex> plk(part_mu_);
+            for (auto& part : part_states_) {
+                std::lock_guard<std::mutex> lk(part->ack_mu);
+                if (!part->ack_dirty) continue;
+
+                if (!list) list = rd_kafka_topic_partition_list_new(4);
+                auto* tp = rd_kafka_topic_partition_list_add(list, part->topic.c_str(), part->partition);
+                tp->offset = part->ack_next;
+                part->ack_dirty = false;
+            }
+        }
+
+        if (!list) return;
+
+        rd_kafka_commit(rk_, list, async ? 1 : 0);
+        rd_kafka_topic_partition_list_destroy(list);
+    }
+
+    /* rebalance: positions restart from the committed offsets */
+    void Core::reset_ack_windows()
+    {
+        std::lock_guard<std::mutex> plk(part_mu_);
+        for (auto& part : part_states_) {
+            std::lock_guard<std::mutex> lk(part->ack_mu);
+            part->ack_window.clear();
+            part->ack_next = -1;
+            part->ack_dirty = false;
+        }
+    }
+
+    /* ============================================================
+     * ======================  Seek / Replay ======================
+     * ============================================================ */
+    int Core::seek_to_offsets(const std::vector<SeekTarget>& targets, std::string& err)
+    {
+        if (source_ && !source_->is_kafka()) {
+            err = "seek: not supported by a replay or synthetic source";
+            return -1;
+        }
+        if (!rk_ || !consumer_th_.joinable()) {
+            err = "seek: consumer not started (subscribe first)";
+            return -1;
+        }
+        if (targets.empty()) return 0;
+
+        {
+            std::lock_guard<std::mutex> lk(seek_mu_);
+            pending_seeks_.insert(pending_seeks_.end(), targets.begin(), targets.end());
+        }
+        seek_pending_.store(true, std::memory_order_release);
+        return 0;
+    }
+
+    int Core::seek_to_timestamp(std::int64_t ts_ms,
+                                const std::vector<std::string>& topics,
+                                std::string& err,
+                                int timeout_ms)
+    {
+        if (source_ && !source_->is_kafka()) {
+            err = "seek: not supported by a replay or synthetic source";
+            return -1;
+        }
+        if (!rk_ || !consumer_th_.joinable()) {
+            err = "seek: consumer not started (subscribe first)";
+            return -1;
+        }
+
+        rd_kafka_topic_partition_list_t* list = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(assign_mu_);
+            if (!assignment_) {
+                err = "seek: no partitions assigned";
+                return -1;
+            }
+
+            list = rd_kafka_topic_partition_list_new(assignment_->cnt);
+            for (int i = 0; i < assignment_->cnt; ++i) {
+                const auto& tp = assignment_->elems[i];
+                if (!topics.empty() &&
+                    std::find(topics.begin(), topics.end(), tp.topic) == topics.end())
+                    continue;
+                rd_kafka_topic_partition_list_add(list, tp.topic, tp.partition)->offset = ts_ms;
+            }
+        }
+
+        if (list->cnt == 0) {
+            rd_kafka_topic_partition_list_destroy(list);
+            err = "seek: none of the topics is assigned";
+            return -1;
+        }
+
+        /* broker round trip: done here, not on the consumer thread */
+        auto rc = rd_kafka_offsets_for_times(rk_, list, timeout_ms);
+        if (rc != RD_KAFKA_RESP_ERR_NO_ERROR) {
+            err = std::string("offsets_for_times: ") + rd_kafka_err2str(rc);
+            rd_kafka_topic_partition_list_destroy(list);
+            return -1;
+        }
+
+        std::vector<SeekTarget> targets;
+        targets.reserve((std::size_t)list->cnt);
+        for (int i = 0; i < list->cnt; ++i) {
+            const auto& tp = list->elems[i];
+            if (tp.err != RD_KAFKA_RESP_ERR_NO_ERROR) {
+                err = std::string("offsets_for_times ") + tp.topic + "/" +
+                      std::to_string(tp.partition) + ": " + rd_kafka_err2str(tp.err);
+                rd_kafka_topic_partition_list_destroy(list);
+                return -1;
+            }
+            // -1: nothing at or after ts_ms, start from the end
+            targets.push_back(SeekTarget{tp.topic, tp.partition,
+                                         tp.offset >= 0 ? tp.offset : RD_KAFKA_OFFSET_END});
+        }
+        rd_kafka_topic_partition_list_destroy(list);
+
+        return seek_to_offsets(targets, err);
+    }
+
+    /* consumer thread, between batches: nothing of the old position can be
+     * dispatched with the new generation from here on */
+    void Core::apply_pending_seeks()
+    {
+        std::vector<SeekTarget> targets;
+        std::uint32_t gen = 0;
+        {
+            std::lock_guard<std::mutex> lk(seek_mu_);
+            targets.swap(pending_seeks_);
+            if (targets.empty()) return;
+
+            gen = seek_gen_.load(std::memory_order_relaxed) + 1;
+            for (const auto& t : targets) {
+                if (t.partition < 0) continue;
+                auto tid = topics_.intern(t.topic);
+                if (tid >= seek_floor_.size()) seek_floor_.resize((std::size_t)tid + 1);
+                auto& parts = seek_floor_[tid];
+                if ((std::size_t)t.partition >= parts.size()) parts.resize((std::size_t)t.partition + 1, 0);
+                parts[(std::size_t)t.partition] = gen;
+            }
+            seek_gen_.store(gen, std::memory_order_release);
+        }
+
+        auto* list = rd_kafka_topic_partition_list_new((int)targets.size());
+        for (const auto& t : targets) {
+            if (t.partition < 0) continue;
+            rd_kafka_topic_partition_list_add(list, t.topic.c_str(), t.partition)->offset = t.offset;
+        }
+
+        if (ack_commit_) {
+            // in-flight offsets of a sought partition will never be acked
+            std::lock_guard<std::mutex> plk(part_mu_);
+            for (auto& part : part_states_) {
+                if (!rd_kafka_topic_partition_list_find(list, part->topic.c_str(), part->partition))
+                    continue;
+                std::lock_guard<std::mutex> lk(part->ack_mu);
+                part->ack_window.clear();
+            }
+        }
+
+        /* A failed partition keeps its position; its flushed events are refetched
+         * on the next seek. An error for the call as a whole leaves no partition
+         * known to have moved. Only the ones that did are caught up. */
+        auto* call_err = rd_kafka_seek_partitions(rk_, list, cfg_.consume_timeout_ms * 10);
+        auto* moved = rd_kafka_topic_partition_list_new(list->cnt);
+        std::size_t failed = 0;
+        std::string first;
+        for (int i = 0; i < list->cnt; ++i) {
+            const auto& tp = list->elems[i];
+            const auto err = tp.err != RD_KAFKA_RESP_ERR_NO_ERROR ? tp.err
+                : call_err ? rd_kafka_error_code(call_err) : RD_KAFKA_RESP_ERR_NO_ERROR;
+            if (err == RD_KAFKA_RESP_ERR_NO_ERROR) {
+                rd_kafka_topic_partition_list_add(moved, tp.topic, tp.partition)->offset = tp.offset;
+                continue;
+            }
+            if (failed++ == 0) {
+                first = std::string("seek ") + tp.topic + "[" + std::to_string(tp.partition) + "]: " +
+                    (tp.err != RD_KAFKA_RESP_ERR_NO_ERROR ? rd_kafka_err2str(tp.err) : rd_kafka_error_string(call_err));
+            }
+        }
+        if (call_err) rd_kafka_error_destroy(call_err);
+        rd_kafka_topic_partition_list_destroy(list);
+
+        if (failed > 0) {
+            seek_errors_.fetch_add(failed, std::memory_order_relaxed);
+            note_error(failed > 1 ? first + " (and " + std::to_string(failed - 1) + " more)" : first);
+        }
+
+        if (cfg_.catchup_batch > 0) {
+            if (catchup_) rd_kafka_topic_partition_list_destroy(catchup_);
+            catchup_ = nullptr;
+        }
+        if (cfg_.catchup_batch > 0 && moved->cnt > 0)
+            catchup_ = moved;
+        else
+            rd_kafka_topic_partition_list_destroy(moved);
+    }
+
+    /* consumer thread: every catch-up partition within catchup_batch of its
+     * (locally cached) high watermark */
+    bool Core::caught_up()
+    {
+        if (rd_kafka_position(rk_, catchup_) != RD_KAFKA_RESP_ERR_NO_ERROR)
+            return false;
+
+        for (int i = 0; i < catchup_->cnt; ++i) {
+            const auto& tp = catchup_->elems[i];
+            if (tp.offset < 0) return false;   // nothing consumed yet
+
+            std::int64_t lo = 0, hi = 0;
+            if (rd_kafka_get_watermark_offsets(rk_, tp.topic, tp.partition, &lo, &hi) !=
+                RD_KAFKA_RESP_ERR_NO_ERROR)
+                return false;
+            if (hi - tp.offset > static_cast<std::int64_t>(cfg_.catchup_batch))
+                return false;
+        }
+        return true;
+    }
+
+    /* drain thread: event dispatched before the last seek of its partition */
+    bool Core::seek_stale(const Event& ev) const noexcept
+    {
+        if (ev.topic_id >= drain_seek_floor_.size() || ev.partition < 0) return false;
+        const auto& parts = drain_seek_floor_[ev.topic_id];
+        if ((std::size_t)ev.partition >= parts.size()) return false;
+        return ev.seek_gen < parts[(std::size_t)ev.partition];
+    }
+
+    bool Core::below_low_watermarks() const noexcept {
+        const auto evt = total_evt_.load(std::memory_order_relaxed);
+
+        // a stalled q keeps us paused even with a short backlog (no pause/resume flapping)
+        return total_raw_.load(std::memory_order_relaxed) <= low_watermark_ &&
+               evt <= evt_low_watermark_ &&
+               !(evt > 0 && drain_stalled());
+    }
+
+    bool Core::drain_stalled() const noexcept {
+        if (cfg_.drain_stall_ms == 0) return false;
+
+        auto idle = mono_ns() - last_drain_ns_.load(std::memory_order_relaxed);
+        return idle > static_cast<std::int64_t>(cfg_.drain_stall_ms) * 1000000;
+    }
+
+    /* ============================================================
+     * ======================  Control Plane ======================
+     * ============================================================ */
+
+    int Core::bind_topic(const std::string& topic,
+                     const std::string& so_path,
+                     const std::string& symbol,
+                     std::string& err)
+    {
+        topics_.intern(topic);
+        return registry_.bind(topic, so_path, symbol, err);
+    }
+
+    int Core::rebind_topic(const std::string& topic,
+                           const std::string& so_path,
+                           const std::string& symbol,
+                           std::string& err)
+    {
+        return registry_.rebind(topic, so_path, symbol, err);
+    }
+
+    int Core::unbind_topic(const std::string& topic)
+    {
+        return registry_.unbind(topic);
+    }
+
+    bool Core::get_topic_decoder(const std::string& topic,
+                                 DecoderRegistry::BindingInfo& out) const
+    {
+        return registry_.get_decoder_info(topic, out);
+    }
+
+    /* ============================================================
+     * ======================  Drain ==============================
+     * ============================================================ */
+
+    void Core::drainTo(std::vector<Event>& out, std::size_t limit) {
+
+        if (evt_qs_.empty())
+            return;
+
+        const auto now = mono_ns();
+        last_drain_ns_.store(now, std::memory_order_relaxed);
+
+        auto gen = seek_gen_.load(std::memory_order_acquire);
+        if (gen != drain_seek_gen_) {
+            std::lock_guard<std::mutex> lk(seek_mu_);
+            drain_seek_floor_ = seek_floor_;
+            drain_seek_gen_ = gen;
+        }
+
+        auto qn = evt_qs_.size();
+        auto start = drain_rr_.fetch_add(1) % qn;
+        std::size_t drained = 0;
+        std::size_t popped = 0;
+
+        for (std::size_t i = 0; i < qn; ++i)
+        {
+            auto idx = (start + i) % qn;
+            const auto before = out.size();
+            const auto popped_before = popped;
+
+            while (out.size() < limit) {
+                auto want = std::min(drain_batch_.size(), limit - out.size());
+                auto got = evt_qs_[idx]->try_pop_n(
+                    std::span<std::unique_ptr<Event>>(drain_batch_.data(), want));
+
+                popped += got;
+
+                for (std::size_t k = 0; k < got; ++k) {
+                    auto& ev = drain_batch_[k];
+
+                    if (drain_seek_gen_ != 0 && seek_stale(*ev)) {
+                        // flushed by a seek: straight back to its worker's pool
+                        const auto worker = ev->worker;
+                        ev->release_msg();
+                        if (worker < free_qs_.size()) (void)free_qs_[worker]->try_push(std::move(ev));
+                        ev.reset();
+                        continue;
+                    }
+
+                    if (cfg_.latency_stats && ev->topic_id != TopicTable::kInvalid && ev->ready_ns != 0) {
+                        auto& st = lat_drain_.topic(ev->topic_id);
+                        st[(std::size_t)LatencyStage::Drain].record(now - ev->ready_ns);
+                        st[(std::size_t)LatencyStage::Total].record(now - ev->poll_ns);
+                    }
+
+                    out.push_back(std::move(*ev));
+                    // keep the empty shell for recycle(); bounded by what the pools can hold
+                    if (drain_shells_.size() < cfg_.evt_queue_size * qn)
+                        drain_shells_.push_back(std::move(ev));
+                    else
+                        ev.reset();
+                }
+
+                if (got < want) break;
+            }
+
+            if (popped > popped_before) {
+                drained += out.size() - before;
+                evt_waits_[idx]->signal();   // room for a parked decode worker
+            }
+            if (out.size() >= limit) break;
+        }
+
+        if (popped > 0) {
+            total_evt_.fetch_sub(popped, std::memory_order_relaxed);
+            drained_.fetch_add(drained, std::memory_order_relaxed);
+
+            if (ack_commit_ && drained > 0)
+                ack_drained(out.data() + (out.size() - drained), drained);
+
+            if (paused_.load(std::memory_order_acquire) && below_low_watermarks())
+                resume_requested_.store(true, std::memory_order_release);
+        }
+
+        // check whether any evt_q still has data
+        bool any_left = false;
+        for (auto& q : evt_qs_) {
+            if (q && q->size() > 0) { any_left = true; break; }
+        }
+
+        KAFKAX_PROBE(drain, drained, any_left);
+
+        if (!any_left) {
+            // all empty -> allow next notify from decode threads
+            evt_notified_.store(false, std::memory_order_release);
+        } else {
+            // still has data -> make eventfd readable again for next sd1 tick
             // keep evt_notified_ = true (still armed)
             uint64_t one = 1;
             (void)::write(efd_, &one, sizeof(one));
         }
     }
 
-    std::size_t Core::next_worker(const rd_kafka_message_t*)
+    void Core::note_error(std::string what)
     {
-        return rr_.fetch_add(1) % cfg_.decode_threads;
+        std::lock_guard<std::mutex> lk(stats_mu_);
+        last_error_ = std::move(what);
+    }
+
+    /* stats_cb: runs on the consumer thread (inside poll) */
+    void Core::on_stats(const char* json, std::size_t len)
+    {
+        KafkaStats st;
+        std::string err;
+        if (!parse_kafka_stats(std::string_view(json, len), st, err)) {
+            note_error("stats: " + err);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(stats_mu_);
+            kafka_stats_ = std::move(st);
+            has_kafka_stats_ = true;
+        }
+
+        if (!prometheus_file_.empty()) {
+            Metrics m;
+            metrics(m);
+            if (!write_prometheus_file(m, prometheus_file_, err))
+                note_error("prometheus: " + err);
+        }
+    }
+
+    void Core::metrics(Metrics& out) const
+    {
+        out.consumed = consumed_.load(std::memory_order_relaxed);
+        out.drained = drained_.load(std::memory_order_relaxed);
+        out.decode_errors = decode_errors_.load(std::memory_order_relaxed);
+        out.kafka_errors = kafka_errors_.load(std::memory_order_relaxed);
+        out.pauses = pauses_.load(std::memory_order_relaxed);
+        out.partition_pauses = part_pauses_.load(std::memory_order_relaxed);
+        out.steals = steals_.load(std::memory_order_relaxed);
+        out.seek_errors = seek_errors_.load(std::memory_order_relaxed);
+        out.raw_depth = total_raw_.load(std::memory_order_relaxed);
+        out.evt_depth = total_evt_.load(std::memory_order_relaxed);
+        out.paused = paused_.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lk(stats_mu_);
+        out.last_error = last_error_;
+        out.has_kafka_stats = has_kafka_stats_;
+        if (has_kafka_stats_) out.kafka = kafka_stats_;
+    }
+
+    void Core::latency(std::vector<LatencyRow>& out) const
+    {
+        if (!cfg_.latency_stats) return;
+
+        std::vector<const LatencyRecorder*> recs;
+        recs.reserve(lat_workers_.size() + 1);
+        for (const auto& r : lat_workers_) recs.push_back(r.get());
+        recs.push_back(&lat_drain_);
+
+        merge_latency(recs, out);
+    }
+
+    void Core::decoder_costs(std::vector<DecoderCost>& out) const
+    {
+        for (const auto& r : cost_workers_) r->merge_into(out);
+    }
+
+    void Core::recent(const std::string& topic, std::vector<FlightRecord>& out) const
+    {
+        auto id = FlightRecorder::kAllTopics;
+        if (!topic.empty()) {
+            id = topics_.find(topic);
+            if (id == TopicTable::kInvalid) return;
+        }
+
+        const auto first = out.size();
+        for (const auto& f : flight_) f->snapshot(id, out);
+        std::stable_sort(out.begin() + first, out.end(), [](const FlightRecord& a, const FlightRecord& b) {
+            return a.ts_ns < b.ts_ns;
+        });
+    }
+
+    bool Core::dump_recent(const std::string& path, std::string& err) const
+    {
+        std::vector<FlightRecord> recs;
+        recent({}, recs);
+
+        std::vector<std::string> names(topics_.size());
+        for (std::size_t i = 0; i < names.size(); ++i)
+            names[i] = topics_.name(static_cast<std::uint32_t>(i));
+
+        return write_flight_records(recs, names, path, err);
+    }
+
+    namespace {
+        inline std::uint64_t mix64(std::uint64_t x) {
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdULL;
+            x ^= x >> 33;
+            x *= 0xc4ceb9fe1a85ec53ULL;
+            x ^= x >> 33;
+            return x;
+        }
+
+        inline std::uint64_t fnv1a(const void* data, std::size_t len) {
+            const auto* p = static_cast<const std::uint8_t*>(data);
+            std::uint64_t h = 0xcbf29ce484222325ULL;
+            for (std::size_t i = 0; i < len; ++i) {
+                h ^= p[i];
+                h *= 0x100000001b3ULL;
+            }
+            return h;
+        }
+
+        /* rkt handles are stable for the lifetime of rk_, so the pointer identifies the topic. */
+        inline std::uint64_t partition_hash(const rd_kafka_message_t* msg) {
+            auto topic = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(msg->rkt));
+            return mix64(topic ^ (static_cast<std::uint64_t>(static_cast<std::uint32_t>(msg->partition)) << 32));
+        }
+    } // namespace
+
+    void Core::recycle(std::vector<Event>& evs) {
+
+        for (auto& ev : evs) {
+            if (ev.worker >= free_qs_.size()) continue;
+
+            std::unique_ptr<Event> shell;
+            if (!drain_shells_.empty()) {
+                shell = std::move(drain_shells_.back());
+                drain_shells_.pop_back();
+            } else {
+                shell = std::make_unique<Event>();
+            }
+
+            auto worker = ev.worker;
+            ev.release_msg();   // zero-copy events give the rdkafka buffer back here
+            *shell = std::move(ev);
+
+            // pool full -> let it go, the worker allocates on miss
+            (void)free_qs_[worker]->try_push(std::move(shell));
+        }
+
+        evs.clear();
+    }
+
+    std::size_t Core::next_worker(const rd_kafka_message_t* msg)
+    {
+        const std::size_t n = cfg_.decode_threads;
+        if (n <= 1) return 0;
+
+        switch (cfg_.route_policy) {
+            case RoutePolicy::PartitionAffinity:
+                if (msg) return partition_hash(msg) % n;
+                break;
+
+            case RoutePolicy::KeyHash:
+                if (msg && msg->key && msg->key_len > 0)
+                    return mix64(fnv1a(msg->key, msg->key_len)) % n;
+                if (msg) return partition_hash(msg) % n;
+                break;
+
+            case RoutePolicy::LeastLoaded: {
+                /* what the ring holds plus what this dispatch() batch has
+                 * already staged for it, or a whole batch lands on one worker */
+                const auto load = [this](std::size_t w) {
+                    return raw_qs_[w]->size() + dispatch_stage_[w].size();
+                };
+
+                /* rotate the scan start so ties do not always land on worker 0 */
+                auto start = rr_.fetch_add(1, std::memory_order_relaxed) % n;
+                auto best = start;
+                auto best_depth = load(start);
+                for (std::size_t i = 1; i < n && best_depth > 0; ++i) {
+                    auto idx = (start + i) % n;
+                    auto depth = load(idx);
+                    if (depth < best_depth) {
+                        best = idx;
+                        best_depth = depth;
+                    }
+                }
+                return best;
+            }
+
+            case RoutePolicy::RoundRobin:
+                break;
+        }
+
+        return rr_.fetch_add(1, std::memory_order_relaxed) % n;
     }
 
 } // namespace kafkax
\ No newline at end of file
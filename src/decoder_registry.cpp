@@ -40,14 +40,15 @@ namespace kafkax {
             return -2;
         }
 
-        if (abi_fn() != KAFKAX_DECODER_ABI_VERSION) {
+        const int abi = abi_fn();
+        if (abi < KAFKAX_DECODER_ABI_VERSION_MIN || abi > KAFKAX_DECODER_ABI_VERSION) {
             err = "decoder ABI version mismatch";
             dlclose(handle);
             return -3;
         }
 
         plugin_idx = loaded_plugins_.size();
-        loaded_plugins_.push_back(PluginHandle{handle, so_path});
+        loaded_plugins_.push_back(PluginHandle{handle, so_path, abi});
         so_to_plugin_[so_path] = plugin_idx;
         return 0;
     }
@@ -72,6 +73,21 @@ namespace kafkax {
         return 0;
     }
 
+    kafkax_decode_batch_fn DecoderRegistry::resolve_batch_symbol(std::size_t plugin_idx,
+                                                                 const std::string& symbol) const
+    {
+        if (plugin_idx >= loaded_plugins_.size() || !loaded_plugins_[plugin_idx].handle) {
+            return nullptr;
+        }
+        if (loaded_plugins_[plugin_idx].abi_version < 3) {
+            return nullptr;
+        }
+
+        auto batch_name = symbol + "_batch";
+        auto* sym = dlsym(loaded_plugins_[plugin_idx].handle, batch_name.c_str());
+        return reinterpret_cast<kafkax_decode_batch_fn>(sym);
+    }
+
     int DecoderRegistry::bind(const std::string& topic,
                               const std::string& so_path,
                               const std::string& symbol,
@@ -90,13 +106,19 @@ namespace kafkax {
             return rc;
     }
 
+        auto batch_fn = resolve_batch_symbol(plugin_idx, symbol);
+
+        const auto id = static_cast<std::uint32_t>(binding_log_.size() + 1);
+        binding_log_.push_back(BindingInfo{so_path, symbol, id});
+
     // New Router
         auto old_router = router_.load(std::memory_order_acquire);
         auto new_router = std::make_shared<Router>(*old_router);
-        new_router->table[topic] = fn;
+        new_router->table[topic] = Route{fn, batch_fn, id};
         router_.store(new_router, std::memory_order_release);
+        generation_.fetch_add(1, std::memory_order_acq_rel);
 
-        topic_bindings_[topic] = BindingEntry{plugin_idx, BindingInfo{so_path, symbol}};
+        topic_bindings_[topic] = BindingEntry{plugin_idx, binding_log_.back()};
         return 0;
     }
 
@@ -111,12 +133,16 @@ namespace kafkax {
 
         std::lock_guard<std::mutex> lk(mu_);
 
+        const auto id = static_cast<std::uint32_t>(binding_log_.size() + 1);
+        binding_log_.push_back(BindingInfo{"builtin:kafkax_core", symbol, id});
+
         auto old_router = router_.load(std::memory_order_acquire);
         auto new_router = std::make_shared<Router>(*old_router);
-        new_router->table[topic] = fn;
+        new_router->table[topic] = Route{fn, nullptr, id};
         router_.store(new_router, std::memory_order_release);
+        generation_.fetch_add(1, std::memory_order_acq_rel);
 
-        topic_bindings_[topic] = BindingEntry{0, BindingInfo{"builtin:kafkax_core", symbol}};
+        topic_bindings_[topic] = BindingEntry{0, binding_log_.back()};
         return 0;
     }
 
@@ -135,6 +161,7 @@ namespace kafkax {
         auto new_router = std::make_shared<Router>(*old_router);
         new_router->table.erase(topic);
         router_.store(new_router, std::memory_order_release);
+        generation_.fetch_add(1, std::memory_order_acq_rel);
 
         topic_bindings_.erase(topic);
         return 0;
@@ -159,4 +186,15 @@ namespace kafkax {
         return true;
     }
 
+    bool DecoderRegistry::binding_info(std::uint32_t id, BindingInfo& out) const
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+
+        if (id == 0 || id > binding_log_.size()) {
+            return false;
+        }
+        out = binding_log_[id - 1];
+        return true;
+    }
+
 } // namespace kafkax
\ No newline at end of file
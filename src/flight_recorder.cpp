@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+
+#include "kafkax/flight_recorder.hpp"
+
+namespace kafkax {
+
+    FlightRecorder::FlightRecorder(std::size_t capacity, std::uint8_t worker)
+        : slots_(std::make_unique<Slot[]>(std::bit_ceil(std::max<std::size_t>(capacity, 1)))),
+          mask_(std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1),
+          worker_(worker)
+    {
+        for (std::size_t i = 0; i <= mask_; ++i) slots_[i].rec.worker = worker_;
+    }
+
+    void FlightRecorder::snapshot(std::uint32_t topic_id, std::vector<FlightRecord>& out) const
+    {
+        const auto head = head_.load(std::memory_order_acquire);
+        const auto n = std::min(head, capacity());
+
+        FlightRecord rec;
+        for (auto pos = head - n; pos < head; ++pos) {
+            const auto& s = slots_[pos & mask_];
+
+            const auto before = s.seq.load(std::memory_order_acquire);
+            if (before == 0 || (before & 1)) continue;   // never written / being written
+            std::memcpy(&rec, &s.rec, sizeof(rec));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) != before) continue;   // overwritten meanwhile
+
+            if (topic_id == kAllTopics || rec.topic_id == topic_id) out.push_back(rec);
+        }
+    }
+
+    bool write_flight_records(const std::vector<FlightRecord>& recs,
+                              const std::vector<std::string>& topic_names,
+                              const std::string& path,
+                              std::string& err)
+    {
+        const auto tmp = path + ".tmp";
+        std::FILE* f = std::fopen(tmp.c_str(), "w");
+        if (!f) {
+            err = tmp + ": " + std::strerror(errno);
+            return false;
+        }
+
+        static const std::string unknown = "?";
+        char hex[FlightRecord::kPrefix * 2 + 1];
+        bool wrote = true;
+        for (const auto& r : recs) {
+            for (std::size_t i = 0; i < r.prefix_len; ++i)
+                std::snprintf(hex + 2 * i, 3, "%02x", r.prefix[i]);
+            hex[2 * r.prefix_len] = '\0';
+
+            const auto& topic = r.topic_id < topic_names.size() ? topic_names[r.topic_id] : unknown;
+            wrote = std::fprintf(f, "%lld\t%u\t%s\t%d\t%lld\t%s\t%u\t%u\t%s\t%.*s\n",
+                                 (long long)r.ts_ns, (unsigned)r.worker, topic.c_str(), r.partition,
+                                 (long long)r.offset, r.status == FlightRecord::Ok ? "ok" : "error",
+                                 r.decode_ns, r.payload_len, hex, (int)r.err_len, r.err) > 0 && wrote;
+        }
+        const bool closed = std::fclose(f) == 0;
+
+        if (!wrote || !closed || std::rename(tmp.c_str(), path.c_str()) != 0) {
+            err = path + ": " + std::strerror(errno);
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+} // namespace kafkax
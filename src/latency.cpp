@@ -0,0 +1,125 @@
+#include <bit>
+
+#include "kafkax/latency.hpp"
+
+namespace kafkax {
+
+    const char* latency_stage_name(LatencyStage s) noexcept
+    {
+        switch (s) {
+            case LatencyStage::Broker:  return "broker";
+            case LatencyStage::Queue:   return "queue";
+            case LatencyStage::Decode:  return "decode";
+            case LatencyStage::Publish: return "publish";
+            case LatencyStage::Drain:   return "drain";
+            case LatencyStage::Total:   return "total";
+            default:                    return "unknown";
+        }
+    }
+
+    std::size_t LatencyHistogram::bucket_of(std::int64_t ns) noexcept
+    {
+        if (ns <= 0) return 0;
+
+        auto v = static_cast<std::uint64_t>(ns);
+        if (v < kSub) return static_cast<std::size_t>(v);
+
+        int e = std::bit_width(v) - 1;   // v in [2^e, 2^(e+1))
+        if (e > kMaxExp) return kBuckets - 1;
+
+        auto sub = (v >> (e - kSubBits)) & (kSub - 1);
+        return static_cast<std::size_t>(e - kSubBits + 1) * kSub + static_cast<std::size_t>(sub);
+    }
+
+    std::int64_t LatencyHistogram::bucket_value(std::size_t b) noexcept
+    {
+        if (b < kSub) return static_cast<std::int64_t>(b);
+
+        int e = static_cast<int>(b / kSub) + kSubBits - 1;
+        auto sub = static_cast<std::uint64_t>(b % kSub);
+        auto width = std::uint64_t{1} << (e - kSubBits);
+        auto lo = (kSub + sub) * width;
+        return static_cast<std::int64_t>(lo + width / 2);
+    }
+
+    void LatencyHistogram::add_to(std::uint64_t* acc) const noexcept
+    {
+        for (std::size_t b = 0; b < kBuckets; ++b)
+            acc[b] += counts_[b].load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t percentiles(const std::uint64_t* acc, std::int64_t out[5]) noexcept
+    {
+        constexpr auto kBuckets = LatencyHistogram::kBuckets;
+        const double qs[4] = {0.50, 0.90, 0.99, 0.999};
+
+        std::uint64_t total = 0;
+        for (std::size_t b = 0; b < kBuckets; ++b) total += acc[b];
+
+        for (std::size_t i = 0; i < 5; ++i) out[i] = 0;
+        if (total == 0) return 0;
+
+        std::uint64_t seen = 0;
+        std::size_t qi = 0;
+        for (std::size_t b = 0; b < kBuckets; ++b) {
+            if (acc[b] == 0) continue;
+            seen += acc[b];
+            while (qi < 4 && static_cast<double>(seen) >= qs[qi] * static_cast<double>(total))
+                out[qi++] = LatencyHistogram::bucket_value(b);
+            out[4] = LatencyHistogram::bucket_value(b);
+        }
+        return total;
+    }
+
+    LatencyRecorder::Stages& LatencyRecorder::grow(std::uint32_t topic_id)
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (topic_id >= topics_.size()) topics_.resize(static_cast<std::size_t>(topic_id) + 1);
+        if (!topics_[topic_id]) topics_[topic_id] = std::make_unique<Stages>();
+        return *topics_[topic_id];
+    }
+
+    void merge_latency(const std::vector<const LatencyRecorder*>& recs,
+                       std::vector<LatencyRow>& out)
+    {
+        constexpr auto kStages = static_cast<std::size_t>(LatencyStage::Count);
+        constexpr auto kBuckets = LatencyHistogram::kBuckets;
+
+        // [topic][stage][bucket]
+        std::vector<std::uint64_t> acc;
+        std::size_t ntopics = 0;
+
+        for (const auto* rec : recs) {
+            if (!rec) continue;
+            rec->for_each([&](std::uint32_t tid, const LatencyRecorder::Stages& st) {
+                if (tid >= ntopics) {
+                    ntopics = static_cast<std::size_t>(tid) + 1;
+                    acc.resize(ntopics * kStages * kBuckets, 0);
+                }
+                for (std::size_t s = 0; s < kStages; ++s)
+                    st[s].add_to(&acc[(tid * kStages + s) * kBuckets]);
+            });
+        }
+
+        for (std::size_t tid = 0; tid < ntopics; ++tid) {
+            for (std::size_t s = 0; s < kStages; ++s) {
+                std::int64_t q[5];
+                const auto total = percentiles(&acc[(tid * kStages + s) * kBuckets], q);
+                if (total == 0) continue;
+
+                LatencyRow row;
+                row.topic_id = static_cast<std::uint32_t>(tid);
+                row.stage = static_cast<LatencyStage>(s);
+                row.count = total;
+                row.p50 = q[0];
+                row.p90 = q[1];
+                row.p99 = q[2];
+                row.p999 = q[3];
+                row.max = q[4];
+
+                out.push_back(row);
+            }
+        }
+    }
+
+} // namespace kafkax
@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <type_traits>
+
+#include "kafkax/capture.hpp"
+#include "kafkax/message_source.hpp"
+
+namespace kafkax {
+
+    namespace {
+        /* _private of every source message points here; librdkafka's own
+         * messages carry their op there, so the two never collide. */
+        char g_source_tag;
+
+    } // namespace
+
+    struct SourceMessagePool::Shell {
+        rd_kafka_message_t msg;   // first: a Shell* is a rd_kafka_message_t*
+        const std::string* topic;
+        std::int64_t timestamp_ms;
+        SourceMessagePool* pool;
+        Shell* next;              // on a free list
+    };
+    static_assert(std::is_standard_layout_v<SourceMessagePool::Shell>);
+
+    namespace {
+        using Shell = SourceMessagePool::Shell;
+
+        inline const Shell* as_shell(const rd_kafka_message_t* msg) noexcept {
+            return reinterpret_cast<const Shell*>(msg);
+        }
+
+        inline std::int64_t mono_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        inline std::int64_t wall_ms() {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        inline void sleep_ns(std::int64_t ns) {
+            if (ns > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(ns));
+        }
+
+        /* ---------------- Kafka ---------------- */
+
+        class KafkaSource final : public MessageSource {
+        public:
+            explicit KafkaSource(rd_kafka_t* rk)
+                : rk_(rk), cq_(rd_kafka_queue_get_consumer(rk)) {}
+
+            ~KafkaSource() override {
+                if (cq_) rd_kafka_queue_destroy(cq_);
+            }
+
+            int subscribe(const std::vector<std::string>& topics, std::string& err) override {
+                auto* list = rd_kafka_topic_partition_list_new(static_cast<int>(topics.size()));
+                for (const auto& t : topics)
+                    rd_kafka_topic_partition_list_add(list, t.c_str(), RD_KAFKA_PARTITION_UA);
+
+                auto r = rd_kafka_subscribe(rk_, list);
+                rd_kafka_topic_partition_list_destroy(list);
+
+                if (r != RD_KAFKA_RESP_ERR_NO_ERROR) {
+                    err = rd_kafka_err2str(r);
+                    return -1;
+                }
+                return 0;
+            }
+
+            std::size_t poll(std::span<rd_kafka_message_t*> out, int timeout_ms) override {
+                if (out.size() == 1) {
+                    out[0] = rd_kafka_consumer_poll(rk_, timeout_ms);
+                    return out[0] ? 1 : 0;
+                }
+                auto r = rd_kafka_consume_batch_queue(cq_, timeout_ms, out.data(), out.size());
+                return r > 0 ? static_cast<std::size_t>(r) : 0;
+            }
+
+            bool is_kafka() const noexcept override { return true; }
+
+        private:
+            rd_kafka_t* rk_;
+            rd_kafka_queue_t* cq_;
+        };
+
+        /* ---------------- Synthetic ---------------- */
+
+        class SyntheticSource final : public MessageSource {
+        public:
+            explicit SyntheticSource(const SourceConfig& cfg) : cfg_(cfg) {}
+
+            int subscribe(const std::vector<std::string>& topics, std::string& err) override {
+                if (topics.empty()) {
+                    err = "synthetic source: no topics";
+                    return -1;
+                }
+                topics_ = topics;
+                offsets_.assign(topics_.size() * static_cast<std::size_t>(cfg_.partitions), 0);
+
+                // messages are windows into one random block, shifted per message
+                const auto per = cfg_.key_size + cfg_.payload_size;
+                bytes_.resize(per + kSpread);
+                std::mt19937_64 rng(cfg_.seed);
+                for (auto& b : bytes_) b = static_cast<std::uint8_t>(rng());
+
+                start_ns_ = mono_ns();
+                return 0;
+            }
+
+            std::size_t poll(std::span<rd_kafka_message_t*> out, int timeout_ms) override {
+                std::size_t n = out.size();
+                if (cfg_.count > 0) n = std::min<std::uint64_t>(n, cfg_.count - produced_);
+                if (n == 0) {
+                    sleep_ns(static_cast<std::int64_t>(timeout_ms) * 1000000);
+                    return 0;
+                }
+
+                if (cfg_.rate > 0) {
+                    const auto due = [&] {
+                        const auto elapsed = static_cast<double>(mono_ns() - start_ns_);
+                        const auto allowed = static_cast<std::uint64_t>(elapsed * 1e-9 * (double)cfg_.rate);
+                        return allowed > produced_ ? allowed - produced_ : 0;
+                    };
+                    auto ready = due();
+                    if (ready == 0) {
+                        // next message is due in 1/rate; wait for it, up to the timeout
+                        const auto gap = static_cast<std::int64_t>(1e9 / (double)cfg_.rate);
+                        sleep_ns(std::min<std::int64_t>(gap, static_cast<std::int64_t>(timeout_ms) * 1000000));
+                        ready = due();
+                        if (ready == 0) return 0;
+                    }
+                    n = std::min<std::uint64_t>(n, ready);
+                }
+
+                const auto ts = wall_ms();
+                const auto nt = topics_.size();
+                const auto np = static_cast<std::uint64_t>(cfg_.partitions);
+                for (std::size_t k = 0; k < n; ++k) {
+                    const auto i = produced_ + k;
+                    const auto t = static_cast<std::size_t>(i % nt);
+                    const auto p = static_cast<std::int32_t>((i / nt) % np);
+                    const auto off = offsets_[t * np + static_cast<std::size_t>(p)]++;
+
+                    const auto* base = bytes_.data() + (i * 61) % kSpread;
+                    out[k] = pool_.make(&topics_[t], p, off, ts,
+                                        cfg_.key_size ? base : nullptr, cfg_.key_size,
+                                        base + cfg_.key_size, cfg_.payload_size);
+                }
+                produced_ += n;
+                return n;
+            }
+
+            bool done() const noexcept override {
+                return cfg_.count > 0 && produced_ >= cfg_.count;
+            }
+
+        private:
+            static constexpr std::size_t kSpread = 64 * 1024;
+
+            const SourceConfig cfg_;
+            SourceMessagePool pool_;
+            std::vector<std::string> topics_;      // fixed after subscribe: messages point at them
+            std::vector<std::int64_t> offsets_;    // [topic * partitions + partition]
+            std::vector<std::uint8_t> bytes_;
+            std::uint64_t produced_{0};
+            std::int64_t start_ns_{0};
+        };
+
+        /* ---------------- Capture replay ---------------- */
+
+        class ReplaySource final : public MessageSource {
+        public:
+            explicit ReplaySource(double speed) : speed_(speed) {}
+
+            bool open(const std::string& path, std::string& err) { return reader_.open(path, err); }
+
+            int subscribe(const std::vector<std::string>& topics, std::string& err) override {
+                if (topics.empty()) {
+                    err = "replay source: no topics";
+                    return -1;
+                }
+                topics_.clear();
+                for (const auto& t : topics) topics_.push_back(std::make_unique<std::string>(t));
+                return 0;
+            }
+
+            std::size_t poll(std::span<rd_kafka_message_t*> out, int timeout_ms) override {
+                const auto deadline = mono_ns() + static_cast<std::int64_t>(timeout_ms) * 1000000;
+
+                std::size_t n = 0;
+                while (n < out.size()) {
+                    if (!pending_topic_ && !next_subscribed()) break;
+
+                    if (speed_ > 0 && pending_.timestamp_ms >= 0) {
+                        const auto now = mono_ns();
+                        if (first_ts_ms_ < 0) {
+                            first_ts_ms_ = pending_.timestamp_ms;
+                            first_ns_ = now;
+                        }
+                        const auto due = first_ns_ + static_cast<std::int64_t>(
+                            static_cast<double>(pending_.timestamp_ms - first_ts_ms_) * 1e6 / speed_);
+                        if (due > now) {
+                            if (n > 0) break;   // hand over what is due, come back for the rest
+                            if (due > deadline) {
+                                sleep_ns(deadline - now);
+                                return 0;
+                            }
+                            sleep_ns(due - now);
+                        }
+                    }
+
+                    out[n++] = pool_.make(pending_topic_, pending_.partition, pending_.offset,
+                                          pending_.timestamp_ms,
+                                          pending_.key.empty() ? nullptr : pending_.key.data(),
+                                          pending_.key.size(),
+                                          pending_.payload.data(), pending_.payload.size());
+                    pending_topic_ = nullptr;
+                }
+
+                if (n == 0 && ended_) sleep_ns(deadline - mono_ns());
+                return n;
+            }
+
+            bool done() const noexcept override { return ended_ && !pending_topic_; }
+
+        private:
+            /* read ahead to the next record of a subscribed topic into pending_ */
+            bool next_subscribed() {
+                while (reader_.next(pending_)) {
+                    for (const auto& t : topics_) {
+                        if (*t == pending_.topic) {
+                            pending_topic_ = t.get();
+                            return true;
+                        }
+                    }
+                }
+                ended_ = true;
+                return false;
+            }
+
+            const double speed_;
+            SourceMessagePool pool_;
+            CaptureReader reader_;
+            std::vector<std::unique_ptr<std::string>> topics_;   // stable: messages point at them
+
+            CaptureRecord pending_;
+            const std::string* pending_topic_{nullptr};   // set while pending_ is unsent
+            bool ended_{false};
+
+            std::int64_t first_ts_ms_{-1};   // recorded pace: first timestamp ...
+            std::int64_t first_ns_{0};       // ... and when it was sent
+        };
+    } // namespace
+
+    std::unique_ptr<MessageSource> make_source(const SourceConfig& cfg, std::string& err)
+    {
+        switch (cfg.kind) {
+        case SourceConfig::Kind::Synthetic:
+            if (cfg.partitions < 1) {
+                err = "synthetic source: partitions must be >= 1";
+                return nullptr;
+            }
+            return std::make_unique<SyntheticSource>(cfg);
+
+        case SourceConfig::Kind::Replay: {
+            if (cfg.path.empty()) {
+                err = "replay source: no capture file";
+                return nullptr;
+            }
+            if (!(cfg.speed >= 0.0)) {
+                err = "replay source: speed must be >= 0";
+                return nullptr;
+            }
+            auto src = std::make_unique<ReplaySource>(cfg.speed);
+            if (!src->open(cfg.path, err)) return nullptr;
+            return src;
+        }
+
+        case SourceConfig::Kind::Kafka:
+            break;
+        }
+        err = "kafka source is created by subscribe";
+        return nullptr;
+    }
+
+    std::unique_ptr<MessageSource> make_kafka_source(rd_kafka_t* rk)
+    {
+        return std::make_unique<KafkaSource>(rk);
+    }
+
+    SourceMessagePool::~SourceMessagePool()
+    {
+        for (auto* list : {local_, returned_.exchange(nullptr, std::memory_order_acquire)}) {
+            while (list) {
+                auto* next = list->next;
+                delete list;
+                list = next;
+            }
+        }
+    }
+
+    rd_kafka_message_t* SourceMessagePool::make(const std::string* topic,
+                                                std::int32_t partition,
+                                                std::int64_t offset,
+                                                std::int64_t timestamp_ms,
+                                                const void* key, std::size_t key_len,
+                                                const void* payload, std::size_t len)
+    {
+        // taking the whole stack at once leaves pushers nothing to ABA on
+        if (!local_) local_ = returned_.exchange(nullptr, std::memory_order_acquire);
+
+        Shell* m;
+        if (local_) {
+            m = local_;
+            local_ = m->next;
+            m->msg = rd_kafka_message_t{};
+        } else {
+            m = new Shell{};
+        }
+
+        m->msg.err = RD_KAFKA_RESP_ERR_NO_ERROR;
+        // never dereferenced: stands in for the topic handle in equality checks and hashing
+        m->msg.rkt = reinterpret_cast<rd_kafka_topic_t*>(const_cast<std::string*>(topic));
+        m->msg.partition = partition;
+        m->msg.payload = const_cast<void*>(payload);
+        m->msg.len = len;
+        m->msg.key = const_cast<void*>(key);
+        m->msg.key_len = key_len;
+        m->msg.offset = offset;
+        m->msg._private = &g_source_tag;
+        m->topic = topic;
+        m->timestamp_ms = timestamp_ms;
+        m->pool = this;
+        m->next = nullptr;
+        return &m->msg;
+    }
+
+    void SourceMessagePool::give_back(Shell* s) noexcept
+    {
+        auto* head = returned_.load(std::memory_order_relaxed);
+        do {
+            s->next = head;
+        } while (!returned_.compare_exchange_weak(head, s, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+    }
+
+    bool is_source_message(const rd_kafka_message_t* msg) noexcept
+    {
+        return msg->_private == &g_source_tag;
+    }
+
+    void release_message(rd_kafka_message_t* msg) noexcept
+    {
+        if (is_source_message(msg)) {
+            auto* s = reinterpret_cast<Shell*>(msg);
+            s->pool->give_back(s);
+        } else
+            rd_kafka_message_destroy(msg);
+    }
+
+    const char* message_topic(const rd_kafka_message_t* msg) noexcept
+    {
+        return is_source_message(msg) ? as_shell(msg)->topic->c_str() : rd_kafka_topic_name(msg->rkt);
+    }
+
+    std::int64_t message_timestamp(const rd_kafka_message_t* msg) noexcept
+    {
+        if (is_source_message(msg)) return as_shell(msg)->timestamp_ms;
+
+        rd_kafka_timestamp_type_t ts_type = RD_KAFKA_TIMESTAMP_NOT_AVAILABLE;
+        return rd_kafka_message_timestamp(msg, &ts_type);
+    }
+
+} // namespace kafkax
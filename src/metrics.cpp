@@ -0,0 +1,285 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "kafkax/metrics.hpp"
+
+namespace kafkax {
+
+    namespace {
+        /* Just enough JSON for librdkafka's stats: a pull parser that walks
+         * objects and lets the caller pick the keys it cares about. */
+        class JsonCursor {
+        public:
+            explicit JsonCursor(std::string_view s) : s_(s) {}
+
+            bool ok() const noexcept { return ok_; }
+
+            void ws() {
+                while (i_ < s_.size() && (s_[i_] == ' ' || s_[i_] == '\n' || s_[i_] == '\r' || s_[i_] == '\t')) ++i_;
+            }
+
+            bool peek(char c) { ws(); return i_ < s_.size() && s_[i_] == c; }
+
+            bool eat(char c) {
+                if (!peek(c)) return fail();
+                ++i_;
+                return true;
+            }
+
+            bool string(std::string& out) {
+                out.clear();
+                if (!eat('"')) return false;
+                while (i_ < s_.size() && s_[i_] != '"') {
+                    char c = s_[i_++];
+                    if (c == '\\' && i_ < s_.size()) {
+                        char e = s_[i_++];
+                        switch (e) {
+                            case 'n': out.push_back('\n'); break;
+                            case 't': out.push_back('\t'); break;
+                            case 'u': i_ += 4; out.push_back('?'); break;   // not used by stats keys
+                            default:  out.push_back(e); break;
+                        }
+                    } else {
+                        out.push_back(c);
+                    }
+                }
+                return eat('"');
+            }
+
+            bool number(std::int64_t& out) {
+                ws();
+                const char* b = s_.data() + i_;
+                char* e = nullptr;
+                double d = std::strtod(b, &e);
+                if (e == b) return fail();
+                i_ += static_cast<std::size_t>(e - b);
+                out = static_cast<std::int64_t>(d);
+                return true;
+            }
+
+            /* skip any value */
+            bool skip() {
+                ws();
+                if (i_ >= s_.size()) return fail();
+                char c = s_[i_];
+                if (c == '"') { std::string tmp; return string(tmp); }
+                if (c == '{' || c == '[') {
+                    const char close = c == '{' ? '}' : ']';
+                    ++i_;
+                    if (peek(close)) { ++i_; return true; }
+                    for (;;) {
+                        if (c == '{') {
+                            std::string k;
+                            if (!string(k) || !eat(':')) return false;
+                        }
+                        if (!skip()) return false;
+                        if (peek(',')) { ++i_; continue; }
+                        return eat(close);
+                    }
+                }
+                // number / true / false / null
+                while (i_ < s_.size() && s_[i_] != ',' && s_[i_] != '}' && s_[i_] != ']' &&
+                       s_[i_] != ' ' && s_[i_] != '\n')
+                    ++i_;
+                return true;
+            }
+
+            /* f(key) for each member; f must consume the value. */
+            template <class F>
+            bool object(F&& f) {
+                if (!eat('{')) return false;
+                if (peek('}')) { ++i_; return true; }
+                std::string key;
+                for (;;) {
+                    if (!string(key) || !eat(':')) return false;
+                    if (!f(key)) return fail();
+                    if (peek(',')) { ++i_; continue; }
+                    return eat('}');
+                }
+            }
+
+        private:
+            bool fail() { ok_ = false; return false; }
+
+            std::string_view s_;
+            std::size_t i_{0};
+            bool ok_{true};
+        };
+
+        bool parse_broker(JsonCursor& c, KafkaStats::Broker& b) {
+            return c.object([&](const std::string& k) {
+                if (k == "name") return c.string(b.name);
+                if (k == "state") return c.string(b.state);
+                if (k == "nodeid") { std::int64_t v; if (!c.number(v)) return false; b.nodeid = (std::int32_t)v; return true; }
+                if (k == "outbuf_cnt") return c.number(b.outbuf_cnt);
+                if (k == "rtt") {
+                    return c.object([&](const std::string& rk) {
+                        if (rk == "avg") return c.number(b.rtt_avg_us);
+                        if (rk == "p99") return c.number(b.rtt_p99_us);
+                        return c.skip();
+                    });
+                }
+                return c.skip();
+            });
+        }
+
+        bool parse_partition(JsonCursor& c, const std::string& topic, KafkaStats::Partition& p) {
+            p.topic = topic;
+            return c.object([&](const std::string& k) {
+                if (k == "partition") { std::int64_t v; if (!c.number(v)) return false; p.partition = (std::int32_t)v; return true; }
+                if (k == "consumer_lag") return c.number(p.consumer_lag);
+                if (k == "fetchq_cnt") return c.number(p.fetchq_cnt);
+                if (k == "fetchq_size") return c.number(p.fetchq_size);
+                if (k == "hi_offset") return c.number(p.hi_offset);
+                if (k == "committed_offset") return c.number(p.committed_offset);
+                return c.skip();
+            });
+        }
+
+        void add(std::vector<MetricSample>& out, const char* name, const char* help, bool counter,
+                 double value, std::string label_key = {}, std::string label = {}, std::int32_t partition = -1) {
+            out.push_back(MetricSample{name, help, counter, std::move(label_key), std::move(label), partition, value});
+        }
+
+        /* label value escaping of the text format: backslash, quote, newline */
+        void append_label_value(std::string& out, const std::string& v)
+        {
+            for (const char c : v) {
+                switch (c) {
+                    case '\\': out += "\\\\"; break;
+                    case '"':  out += "\\\""; break;
+                    case '\n': out += "\\n"; break;
+                    default:   out += c;
+                }
+            }
+        }
+    } // namespace
+
+    bool parse_kafka_stats(std::string_view json, KafkaStats& out, std::string& err)
+    {
+        KafkaStats st;
+        JsonCursor c(json);
+
+        bool ok = c.object([&](const std::string& k) {
+            if (k == "ts") return c.number(st.ts_us);
+            if (k == "brokers") {
+                return c.object([&](const std::string&) {
+                    KafkaStats::Broker b;
+                    if (!parse_broker(c, b)) return false;
+                    st.brokers.push_back(std::move(b));
+                    return true;
+                });
+            }
+            if (k == "topics") {
+                return c.object([&](const std::string& topic) {
+                    return c.object([&](const std::string& tk) {
+                        if (tk != "partitions") return c.skip();
+                        return c.object([&](const std::string&) {
+                            KafkaStats::Partition p;
+                            if (!parse_partition(c, topic, p)) return false;
+                            if (p.partition >= 0) st.partitions.push_back(std::move(p));
+                            return true;
+                        });
+                    });
+                });
+            }
+            return c.skip();
+        });
+
+        if (!ok || !c.ok()) {
+            err = "malformed stats JSON";
+            return false;
+        }
+        out = std::move(st);
+        return true;
+    }
+
+    void flatten_metrics(const Metrics& m, std::vector<MetricSample>& out)
+    {
+        add(out, "kafkax_consumed_total", "Messages handed to decode", true, (double)m.consumed);
+        add(out, "kafkax_drained_total", "Events returned to q", true, (double)m.drained);
+        add(out, "kafkax_decode_errors_total", "Error events produced by decode", true, (double)m.decode_errors);
+        add(out, "kafkax_kafka_errors_total", "librdkafka errors (error_cb and message errors)", true, (double)m.kafka_errors);
+        add(out, "kafkax_pauses_total", "Global backpressure pauses", true, (double)m.pauses);
+        add(out, "kafkax_partition_pauses_total", "Per-partition backpressure pauses", true, (double)m.partition_pauses);
+        add(out, "kafkax_steals_total", "Batches decoded by work stealing", true, (double)m.steals);
+        add(out, "kafkax_seek_errors_total", "Partitions a seek failed to move", true, (double)m.seek_errors);
+        add(out, "kafkax_raw_queue_depth", "Messages waiting in raw rings", false, (double)m.raw_depth);
+        add(out, "kafkax_event_queue_depth", "Events waiting in event rings", false, (double)m.evt_depth);
+        add(out, "kafkax_paused", "1 while the assignment is paused for backpressure", false, m.paused ? 1.0 : 0.0);
+
+        if (!m.has_kafka_stats) return;
+
+        // one metric at a time: exposition format wants each family contiguous
+        for (const auto& p : m.kafka.partitions)
+            add(out, "kafkax_consumer_lag", "Consumer lag (messages), from librdkafka stats", false,
+                (double)p.consumer_lag, "topic", p.topic, p.partition);
+        for (const auto& p : m.kafka.partitions)
+            add(out, "kafkax_fetchq_messages", "librdkafka fetch queue (messages)", false,
+                (double)p.fetchq_cnt, "topic", p.topic, p.partition);
+        for (const auto& p : m.kafka.partitions)
+            add(out, "kafkax_fetchq_bytes", "librdkafka fetch queue (bytes)", false,
+                (double)p.fetchq_size, "topic", p.topic, p.partition);
+
+        for (const auto& b : m.kafka.brokers)
+            if (b.rtt_avg_us >= 0)
+                add(out, "kafkax_broker_rtt_avg_seconds", "Broker round trip time (avg)", false,
+                    (double)b.rtt_avg_us / 1e6, "broker", b.name);
+        for (const auto& b : m.kafka.brokers)
+            if (b.rtt_p99_us >= 0)
+                add(out, "kafkax_broker_rtt_p99_seconds", "Broker round trip time (p99)", false,
+                    (double)b.rtt_p99_us / 1e6, "broker", b.name);
+    }
+
+    std::string render_prometheus(const Metrics& m)
+    {
+        std::vector<MetricSample> samples;
+        flatten_metrics(m, samples);
+
+        std::string out;
+        out.reserve(samples.size() * 96);
+
+        const char* last = nullptr;
+        char num[64];
+        for (const auto& s : samples) {
+            if (!last || std::strcmp(last, s.name) != 0) {
+                out += "# HELP "; out += s.name; out += ' '; out += s.help; out += '\n';
+                out += "# TYPE "; out += s.name; out += s.counter ? " counter\n" : " gauge\n";
+                last = s.name;
+            }
+            out += s.name;
+            if (!s.label_key.empty()) {
+                out += '{'; out += s.label_key; out += "=\""; append_label_value(out, s.label); out += '"';
+                if (s.partition >= 0) { out += ",partition=\""; out += std::to_string(s.partition); out += '"'; }
+                out += '}';
+            }
+            std::snprintf(num, sizeof(num), " %.9g\n", s.value);
+            out += num;
+        }
+        return out;
+    }
+
+    bool write_prometheus_file(const Metrics& m, const std::string& path, std::string& err)
+    {
+        const auto text = render_prometheus(m);
+        const auto tmp = path + ".tmp";
+
+        std::FILE* f = std::fopen(tmp.c_str(), "w");
+        if (!f) {
+            err = tmp + ": " + std::strerror(errno);
+            return false;
+        }
+        const bool wrote = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+        const bool closed = std::fclose(f) == 0;
+
+        if (!wrote || !closed || std::rename(tmp.c_str(), path.c_str()) != 0) {
+            err = path + ": " + std::strerror(errno);
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+} // namespace kafkax
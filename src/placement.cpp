@@ -0,0 +1,124 @@
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstdlib>
+#include <cstring>
+
+#include "kafkax/placement.hpp"
+
+namespace kafkax::placement {
+
+    namespace {
+        constexpr std::size_t kHugePage = 2 * 1024 * 1024;
+
+        /* linux/mempolicy.h; spelled out so no libnuma/kernel headers are needed */
+        constexpr int kMpolPreferred = 1;
+
+        inline std::size_t round_up(std::size_t n, std::size_t to) {
+            return (n + to - 1) / to * to;
+        }
+    } // namespace
+
+    bool parse_cpu_list(const std::string& spec, std::vector<int>& cpus)
+    {
+        std::vector<int> out;
+        const char* p = spec.c_str();
+
+        while (*p) {
+            if (*p == ',' || *p == ' ') { ++p; continue; }
+
+            char* end = nullptr;
+            errno = 0;
+            long lo = std::strtol(p, &end, 10);
+            if (end == p || errno == ERANGE || lo < 0 || lo >= CPU_SETSIZE) return false;
+            long hi = lo;
+            p = end;
+
+            if (*p == '-') {
+                ++p;
+                errno = 0;
+                hi = std::strtol(p, &end, 10);
+                // no CPU past what a cpu_set_t can name: also bounds the expansion
+                if (end == p || errno == ERANGE || hi < lo || hi >= CPU_SETSIZE) return false;
+                p = end;
+            }
+            if (*p && *p != ',' && *p != ' ') return false;
+
+            for (long c = lo; c <= hi; ++c) out.push_back(static_cast<int>(c));
+        }
+
+        cpus.swap(out);
+        return true;
+    }
+
+    int pin_current_thread(const std::vector<int>& cpus)
+    {
+        if (cpus.empty()) return 0;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : cpus) {
+            if (c < CPU_SETSIZE) CPU_SET(c, &set);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    void name_current_thread(const std::string& name)
+    {
+        (void)pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+    }
+
+    int cpu_node(int cpu)
+    {
+        const std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        DIR* d = ::opendir(dir.c_str());
+        if (!d) return -1;
+
+        int node = -1;
+        while (auto* ent = ::readdir(d)) {
+            if (std::strncmp(ent->d_name, "node", 4) == 0 && ent->d_name[4] >= '0' && ent->d_name[4] <= '9') {
+                node = std::atoi(ent->d_name + 4);
+                break;
+            }
+        }
+        ::closedir(d);
+        return node;
+    }
+
+    void* alloc_pages(std::size_t bytes, const MemPolicy& policy)
+    {
+        void* p = MAP_FAILED;
+        std::size_t len = round_up(bytes, policy.huge ? kHugePage : 4096);
+
+        if (policy.huge) {
+            p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+        if (p == MAP_FAILED) {
+            // no reserved hugetlb pages: ordinary mapping, ask for THP instead
+            p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) return nullptr;
+            if (policy.huge) (void)::madvise(p, len, MADV_HUGEPAGE);
+        }
+
+        if (policy.node >= 0 && policy.node < 64) {
+            // preferred, not bound: a full node degrades to remote memory instead of failing
+            unsigned long mask = 1UL << policy.node;
+            (void)::syscall(SYS_mbind, p, len, kMpolPreferred, &mask, 64UL, 0U);
+        }
+        return p;
+    }
+
+    void free_pages(void* p, std::size_t bytes, const MemPolicy& policy) noexcept
+    {
+        if (!p) return;
+        // same length alloc_pages mapped, whichever page size it ended up with
+        (void)::munmap(p, round_up(bytes, policy.huge ? kHugePage : 4096));
+    }
+
+} // namespace kafkax::placement
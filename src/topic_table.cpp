@@ -0,0 +1,42 @@
+#include "kafkax/topic_table.hpp"
+
+namespace kafkax {
+
+    std::uint32_t TopicTable::intern(std::string_view name)
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+
+        std::string key(name);
+        if (auto it = ids_.find(key); it != ids_.end()) {
+            return it->second;
+        }
+
+        auto id = static_cast<std::uint32_t>(names_.size());
+        names_.push_back(key);
+        ids_.emplace(std::move(key), id);
+        return id;
+    }
+
+    std::uint32_t TopicTable::find(std::string_view name) const
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+
+        auto it = ids_.find(std::string(name));
+        return it == ids_.end() ? kInvalid : it->second;
+    }
+
+    const std::string& TopicTable::name(std::uint32_t id) const
+    {
+        static const std::string empty;
+
+        std::lock_guard<std::mutex> lk(mu_);
+        return id < names_.size() ? names_[id] : empty;
+    }
+
+    std::size_t TopicTable::size() const
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        return names_.size();
+    }
+
+} // namespace kafkax
@@ -0,0 +1,131 @@
+// RoutePolicy::LeastLoaded with a whole consume batch in one dispatch():
+// the batch must spread over the workers by ring depth plus what the batch
+// has already staged for each, not all land on the one shortest ring.
+//
+// Workers 1..N-1 are stalled on full event rings (nothing drains) with a
+// small raw backlog; worker 0 is free. One dispatch() of a batch then has to
+// put part of it behind the stalled workers.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kafkax/core.hpp"
+#include "kafkax/message_source.hpp"
+
+namespace kafkax {
+
+    /* Test-only access to Core (friend of Core); the test thread stands in
+     * for the consumer thread, which idles on a source that never delivers. */
+    struct CoreTest {
+        static std::size_t raw_depth(const Core& c, std::size_t w) { return c.raw_qs_[w]->size(); }
+
+        static bool push_raw(Core& c, std::size_t w, rd_kafka_message_t* msg) {
+            c.total_raw_.fetch_add(1, std::memory_order_relaxed);
+            if (!c.raw_qs_[w]->try_push(Core::RawMsg(msg))) {
+                c.total_raw_.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+            c.raw_epochs_[w]->signal();
+            return true;
+        }
+
+        static std::size_t dispatch(Core& c, std::vector<rd_kafka_message_t*>& msgs) {
+            return c.dispatch(msgs.data(), msgs.size());
+        }
+    };
+
+} // namespace kafkax
+
+namespace {
+
+    constexpr std::size_t kWorkers = 4;
+    constexpr std::size_t kBatch = 64;
+
+    [[noreturn]] void fail(const std::string& what) {
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+        std::exit(1);
+    }
+
+    class IdleSource final : public kafkax::MessageSource {
+    public:
+        int subscribe(const std::vector<std::string>&, std::string&) override { return 0; }
+
+        std::size_t poll(std::span<rd_kafka_message_t*>, int timeout_ms) override {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+            return 0;
+        }
+    };
+
+    /* until the worker stops popping: its depth holds still for a while */
+    std::size_t settled_depth(const kafkax::Core& core, std::size_t w) {
+        auto depth = kafkax::CoreTest::raw_depth(core, w);
+        for (int still = 0; still < 20;) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            const auto now = kafkax::CoreTest::raw_depth(core, w);
+            still = now == depth ? still + 1 : 0;
+            depth = now;
+        }
+        return depth;
+    }
+
+} // namespace
+
+int main() {
+    static const std::string topic = "kafkax.test.leastloaded";
+    const std::string payload(32, 'x');
+
+    kafkax::SourceMessagePool shells;   // outlives core: queued messages go back into it
+    std::int64_t offset = 0;
+    const auto make = [&] {
+        return shells.make(&topic, 0, offset++, -1, nullptr, 0, payload.data(), payload.size());
+    };
+
+    kafkax::Core::DecodeConfig dcfg{};
+    dcfg.decode_threads = kWorkers;
+    dcfg.raw_queue_size = 1024;
+    dcfg.evt_queue_size = kBatch;
+    dcfg.route_policy = kafkax::Core::RoutePolicy::LeastLoaded;
+    dcfg.consume_batch = kBatch;
+
+    auto core = std::make_unique<kafkax::Core>(dcfg);
+    std::string err;
+    if (core->set_source(std::make_unique<IdleSource>(), err) != 0 ||
+        core->subscribe({topic}, err) != 0)
+        fail("setup: " + err);
+
+    // stall workers 1..N-1: feed one message at a time until one stays queued
+    std::size_t before[kWorkers] = {};
+    for (std::size_t w = 1; w < kWorkers; ++w) {
+        for (;;) {
+            if (kafkax::CoreTest::raw_depth(*core, w) == 0) {
+                if (!kafkax::CoreTest::push_raw(*core, w, make())) fail("raw ring full");
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            if ((before[w] = settled_depth(*core, w)) > 0) break;
+        }
+    }
+
+    std::vector<rd_kafka_message_t*> batch(kBatch);
+    for (auto& m : batch) m = make();
+    if (kafkax::CoreTest::dispatch(*core, batch) != kBatch) fail("dispatch");
+
+    std::size_t behind_stalled = 0;
+    for (std::size_t w = 1; w < kWorkers; ++w)
+        behind_stalled += settled_depth(*core, w) - before[w];
+
+    // depths 0 / before[w] with nothing staged would send all kBatch to worker 0
+    const std::size_t expect = kBatch / kWorkers;
+    if (behind_stalled < expect) {
+        fail("only " + std::to_string(behind_stalled) + " of " + std::to_string(kBatch) +
+             " batch messages went to the stalled workers");
+    }
+
+    core.reset();
+    std::printf("ok: %zu of %zu batch messages spread past worker 0\n", behind_stalled, kBatch);
+    return 0;
+}
@@ -0,0 +1,58 @@
+// placement::parse_cpu_list: taskset lists, and rejection of malformed,
+// oversized and overflowing input without touching the output.
+#include <sched.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "kafkax/placement.hpp"
+
+namespace {
+
+    int failures = 0;
+
+    void expect(const std::string& spec, bool ok, const std::vector<int>& want = {}) {
+        std::vector<int> cpus{-1};   // sentinel: a rejected list must leave it alone
+        const bool got = kafkax::placement::parse_cpu_list(spec, cpus);
+        const auto expected = ok ? want : std::vector<int>{-1};
+        if (got != ok || cpus != expected) {
+            std::fprintf(stderr, "FAIL: \"%s\": returned %d, %zu cpus\n", spec.c_str(), got, cpus.size());
+            ++failures;
+        }
+    }
+
+} // namespace
+
+int main() {
+    expect("", true, {});
+    expect("3", true, {3});
+    expect("0-3,8,10-11", true, {0, 1, 2, 3, 8, 10, 11});
+    expect("1, 2", true, {1, 2});
+    expect("0-" + std::to_string(CPU_SETSIZE - 1), true, [] {
+        std::vector<int> all;
+        for (int c = 0; c < CPU_SETSIZE; ++c) all.push_back(c);
+        return all;
+    }());
+
+    // malformed
+    expect("x", false);
+    expect("-1", false);
+    expect("3-1", false);
+    expect("1-", false);
+    expect("1;2", false);
+
+    // oversized: past cpu_set_t, and a range that would expand to billions
+    expect(std::to_string(CPU_SETSIZE), false);
+    expect("0-" + std::to_string(CPU_SETSIZE), false);
+    expect("0-2000000000", false);
+
+    // overflow: strtol saturates with ERANGE, int would truncate
+    expect("99999999999999999999", false);
+    expect("0-99999999999999999999", false);
+    expect("4294967296", false);
+
+    if (failures) return 1;
+    std::printf("ok\n");
+    return 0;
+}